@@ -57,4 +57,24 @@ struct Access
     void PtrToOffset(void *ref) { m_offset = static_cast<char *>(m_ptr) - static_cast<char *>(ref); }
 };
 
+/*
+    Struct for accessing resources referenced by a 32-bit offset relative to the position of the offset itself.
+    (such offsets are used inside the Data section; they are not in the offset table, so they are never converted to pointers)
+    ____________________________________________________________________________________________________________________________
+*/
+
+template <typename T>
+struct RelativeAccess
+{
+    int m_offset; // offset from the address of this field
+
+    const T &operator[](int idx) const { return ptr()[idx]; }
+
+    const T *operator->() const { return ptr(); }
+
+    const T *ptr() const { return reinterpret_cast<const T *>(reinterpret_cast<const char *>(this) + m_offset); }
+
+    const T &ref() const { return *ptr(); }
+};
+
 #endif
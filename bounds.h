@@ -0,0 +1,138 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOUNDS_SSE2
+#endif
+
+// bounding volumes of a submesh: axis-aligned box and sphere around its center
+struct BoundingVolume
+{
+    glm::vec3 Min;
+    glm::vec3 Max;
+    glm::vec3 Center;
+    float Radius;
+};
+
+//! Computes the bounds of the vertices referenced by an index list; vertices are vertexSize floats (at least 4) starting with the position.
+inline BoundingVolume ComputeBounds(const float *vertices, int vertexSize, const unsigned short *indices, size_t indexCount)
+{
+    BoundingVolume bounds;
+
+    if (indexCount == 0)
+    {
+        bounds.Min = bounds.Max = bounds.Center = glm::vec3(0.0f);
+        bounds.Radius = 0.0f;
+        return bounds;
+    }
+
+#ifdef BOUNDS_SSE2
+    // each position is loaded with the next float of the vertex, which is ignored
+    __m128 minimum = _mm_set1_ps(FLT_MAX), maximum = _mm_set1_ps(-FLT_MAX);
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        __m128 position = _mm_loadu_ps(vertices + (size_t)indices[i] * vertexSize);
+        minimum = _mm_min_ps(minimum, position);
+        maximum = _mm_max_ps(maximum, position);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, minimum);
+    bounds.Min = glm::vec3(lanes[0], lanes[1], lanes[2]);
+    _mm_storeu_ps(lanes, maximum);
+    bounds.Max = glm::vec3(lanes[0], lanes[1], lanes[2]);
+
+    bounds.Center = (bounds.Min + bounds.Max) * 0.5f;
+
+    // the radius is the largest distance from the center (the 4th lane is masked out)
+    __m128 center = _mm_setr_ps(bounds.Center.x, bounds.Center.y, bounds.Center.z, 0.0f);
+    __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    __m128 largest = _mm_setzero_ps();
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        __m128 offset = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(vertices + (size_t)indices[i] * vertexSize), center), mask);
+        __m128 squared = _mm_mul_ps(offset, offset);
+        squared = _mm_add_ss(_mm_add_ss(squared, _mm_shuffle_ps(squared, squared, 1)), _mm_shuffle_ps(squared, squared, 2));
+        largest = _mm_max_ss(largest, squared);
+    }
+
+    bounds.Radius = sqrtf(_mm_cvtss_f32(largest));
+#else
+    bounds.Min = glm::vec3(FLT_MAX);
+    bounds.Max = glm::vec3(-FLT_MAX);
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        glm::vec3 position = glm::make_vec3(vertices + (size_t)indices[i] * vertexSize);
+        bounds.Min = glm::min(bounds.Min, position);
+        bounds.Max = glm::max(bounds.Max, position);
+    }
+
+    bounds.Center = (bounds.Min + bounds.Max) * 0.5f;
+    bounds.Radius = 0.0f;
+
+    for (size_t i = 0; i < indexCount; i++)
+        bounds.Radius = std::max(bounds.Radius, glm::length(glm::make_vec3(vertices + (size_t)indices[i] * vertexSize) - bounds.Center));
+#endif
+
+    return bounds;
+}
+
+//! Merges two bounding volumes (the sphere encloses both spheres around the center of the merged box).
+inline BoundingVolume MergeBounds(const BoundingVolume &a, const BoundingVolume &b)
+{
+    BoundingVolume bounds;
+    bounds.Min = glm::min(a.Min, b.Min);
+    bounds.Max = glm::max(a.Max, b.Max);
+    bounds.Center = (bounds.Min + bounds.Max) * 0.5f;
+    bounds.Radius = std::max(glm::length(a.Center - bounds.Center) + a.Radius, glm::length(b.Center - bounds.Center) + b.Radius);
+    return bounds;
+}
+
+// view frustum as 6 planes (normal pointing inside, distance) taken from a view-projection matrix
+class Frustum
+{
+public:
+    glm::vec4 Planes[6]; // left, right, bottom, top, near, far
+
+    //! Extracts the planes from the rows of the view-projection matrix (Gribb / Hartmann).
+    Frustum(const glm::mat4 &viewProjection)
+    {
+        glm::mat4 rows = glm::transpose(viewProjection);
+
+        for (int i = 0; i < 3; i++)
+        {
+            Planes[i * 2] = rows[3] + rows[i];
+            Planes[i * 2 + 1] = rows[3] - rows[i];
+        }
+
+        for (int i = 0; i < 6; i++)
+            Planes[i] /= glm::length(glm::vec3(Planes[i]));
+    }
+
+    //! Returns false if the volume is entirely outside of one of the planes (the sphere is tested first, then the corner of the box farthest along the plane normal).
+    bool isVisible(const BoundingVolume &bounds) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            glm::vec3 normal(Planes[i]);
+
+            if (glm::dot(normal, bounds.Center) + Planes[i].w < -bounds.Radius)
+                return false;
+
+            glm::vec3 corner(normal.x >= 0.0f ? bounds.Max.x : bounds.Min.x, normal.y >= 0.0f ? bounds.Max.y : bounds.Min.y, normal.z >= 0.0f ? bounds.Max.z : bounds.Min.z);
+
+            if (glm::dot(normal, corner) + Planes[i].w < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef __BRESFORMAT_H_INCLUDED__
+#define __BRESFORMAT_H_INCLUDED__
+
+#include <cstdint>
+#include <cstring>
+#include "resFile.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BRES_HOST_BIG_ENDIAN true
+#else
+#define BRES_HOST_BIG_ENDIAN false
+#endif
+
+/*
+    The 4 subversions of a .bdae (BRES) file: little or big endian, with 32-bit or 64-bit offsets (written for a 32-bit or a 64-bit game engine).
+    The header and the offset table differ only by the byte order and the width of the offsets, so they are described once by templates, and each subversion gets its own instantiation of the conversion to the in-memory (host) form; the parser picks the instantiation once per file.
+    The data itself is laid out for the pointer size of the engine it was written for (every pointer in the data is an offset of that width), and its counts, vertices and indices are in the byte order of the file; they are not converted, so File::Init() loads only files of the host's pointer size and byte order (little-endian 64-bit on the usual hosts).
+    The headers of all 4 subversions are converted, so File::Scan() reads the metadata of any of them.
+    ____________________________________________________________________________________________________________________________________________________________________________________________
+*/
+
+// on-disk header of a .bdae file with offsets of type OffsetType (see FileHeaderData)
+template <typename OffsetType>
+struct FileHeaderLayout
+{
+    unsigned int signature;
+    unsigned short endianCheck;
+    unsigned short version;
+    unsigned int sizeOfHeader;
+    unsigned int sizeOfFile;
+    unsigned int numOffsets;
+    unsigned int origin;
+    OffsetType offsets;
+    OffsetType stringData;
+    OffsetType data;
+    OffsetType relatedFiles;
+    OffsetType removable;
+    unsigned int sizeOfRemovableChunk;
+    unsigned int nbOfRemovableChunks;
+    unsigned int useSeparatedAllocationForRemovableBuffers;
+    unsigned int sizeOfDynamicChunk;
+};
+
+static_assert(sizeof(FileHeaderLayout<uint32_t>) == 60, "32-bit header layout");
+static_assert(sizeof(FileHeaderLayout<uint64_t>) == 80, "64-bit header layout");
+
+// byte swapping of values
+// _________________________
+
+inline uint16_t SwapBytes(uint16_t v) { return (uint16_t)((v >> 8) | (v << 8)); }
+
+inline uint32_t SwapBytes(uint32_t v)
+{
+    return (v >> 24) | ((v >> 8) & 0x0000ff00) | ((v << 8) & 0x00ff0000) | (v << 24);
+}
+
+inline uint64_t SwapBytes(uint64_t v)
+{
+    return ((uint64_t)SwapBytes((uint32_t)v) << 32) | SwapBytes((uint32_t)(v >> 32));
+}
+
+/*
+    Conversion of one subversion to the host form. Swap is true when the byte order of the file differs from the host's; every function is a plain copy for the native subversion.
+*/
+
+template <bool Swap, typename OffsetType>
+struct BRESVariant
+{
+    template <typename T>
+    static T ToHost(T v) { return Swap ? SwapBytes(v) : v; }
+
+    // converts the raw on-disk header into the in-memory header
+    static void ConvertHeader(const void *raw, FileHeaderData *header)
+    {
+        FileHeaderLayout<OffsetType> h;
+        memcpy(&h, raw, sizeof(h));
+        *header = FileHeaderData();
+
+        header->signature = h.signature; // (a sequence of characters, not a number)
+        header->endianCheck = ToHost(h.endianCheck);
+        header->version = ToHost(h.version);
+        header->sizeOfHeader = ToHost(h.sizeOfHeader);
+        header->sizeOfFile = ToHost(h.sizeOfFile);
+        header->numOffsets = ToHost(h.numOffsets);
+        header->origin = ToHost(h.origin);
+        header->offsets.m_offset = ToHost(h.offsets);
+        header->stringData.m_offset = ToHost(h.stringData);
+        header->data.m_offset = ToHost(h.data);
+        header->relatedFiles.m_offset = ToHost(h.relatedFiles);
+        header->removable.m_offset = ToHost(h.removable);
+        header->sizeOfRemovableChunk = ToHost(h.sizeOfRemovableChunk);
+        header->nbOfRemovableChunks = ToHost(h.nbOfRemovableChunks);
+        header->useSeparatedAllocationForRemovableBuffers = ToHost(h.useSeparatedAllocationForRemovableBuffers);
+        header->sizeOfDynamicChunk = ToHost(h.sizeOfDynamicChunk);
+    }
+
+    // converts a 32-bit value (string length, related file name size) read by File::Scan()
+    static uint32_t Convert32(uint32_t v) { return ToHost(v); }
+};
+
+// the functions of one subversion, chosen once per file
+struct BRESVariantFunctions
+{
+    const char *Name;
+    bool BigEndian;
+    int OffsetSize; // size of the offsets (and pointers) of the file in bytes
+
+    void (*ConvertHeader)(const void *raw, FileHeaderData *header);
+    uint32_t (*Convert32)(uint32_t v);
+};
+
+template <bool BigEndian, typename OffsetType>
+const BRESVariantFunctions *GetBRESVariant(const char *name)
+{
+    typedef BRESVariant<BigEndian != BRES_HOST_BIG_ENDIAN, OffsetType> Variant;
+
+    static const BRESVariantFunctions functions = {
+        name,
+        BigEndian,
+        sizeof(OffsetType),
+        &Variant::ConvertHeader,
+        &Variant::Convert32};
+
+    return &functions;
+}
+
+// number of bytes needed to detect the subversion of a file (signature, endian check, version, header size)
+#define BRES_DETECT_SIZE 12
+
+// returns the subversion of a file from the beginning of its header, or NULL if it isn't a known .bdae file
+inline const BRESVariantFunctions *DetectBRESVariant(const void *raw)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(raw);
+
+    // the byte order mark 0xFEFF is stored as FF FE by little endian files and as FE FF by big endian ones
+    bool bigEndian;
+
+    if (bytes[4] == 0xFF && bytes[5] == 0xFE)
+        bigEndian = false;
+    else if (bytes[4] == 0xFE && bytes[5] == 0xFF)
+        bigEndian = true;
+    else
+        return NULL;
+
+    uint32_t sizeOfHeader;
+    memcpy(&sizeOfHeader, bytes + 8, sizeof(sizeOfHeader));
+
+    if (bigEndian != BRES_HOST_BIG_ENDIAN)
+        sizeOfHeader = SwapBytes(sizeOfHeader);
+
+    if (sizeOfHeader == sizeof(FileHeaderLayout<uint32_t>))
+        return bigEndian ? GetBRESVariant<true, uint32_t>("big-endian 32-bit") : GetBRESVariant<false, uint32_t>("little-endian 32-bit");
+
+    if (sizeOfHeader == sizeof(FileHeaderLayout<uint64_t>))
+        return bigEndian ? GetBRESVariant<true, uint64_t>("big-endian 64-bit") : GetBRESVariant<false, uint64_t>("little-endian 64-bit");
+
+    return NULL;
+}
+
+#endif
@@ -124,6 +124,21 @@ public:
         inputDir = glm::vec3(0.0f);
     }
 
+    //! Places the camera in front of a bounding sphere (looking along -Z at its center, as with the default orientation), at the distance where the sphere fits the vertical field of view; stops any movement.
+    void Frame(const glm::vec3 &center, float radius)
+    {
+        Yaw = YAW;
+        Pitch = PITCH;
+        Zoom = ZOOM;
+        updateCameraVectors();
+
+        float distance = std::max(radius, 0.01f) / sin(glm::radians(Zoom) / 2.0f);
+        Position = center - Front * distance;
+
+        moveDir = inputDir = glm::vec3(0.0f);
+        MovementSpeed = 0.0f;
+    }
+
 private:
     //! Calculates the new Front vector from the camera's updated Euler Angles, and also updates Right and Up vectors (private helper function, not for external use).
     void updateCameraVectors()
@@ -0,0 +1,54 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "gltfExport.h"
+#include "fileCache.h"
+
+/*
+    Command line tool for the glTF export:
+
+    exporter [--weld] [--optimize] [--archive-index] <model directory> <output directory> [threads]   – exports every .bdae model under the directory as a .glb file (with the same subpath)
+
+    --weld           merges the bit-identical vertices of each mesh
+    --optimize       reorders the triangles and vertices of each mesh for the GPU
+    --archive-index  keeps the file list of each model archive in an index file next to it (<model>.bdae.idx), so that later runs map it instead of scanning the archive
+
+    Texture files are searched the same way as in the viewer, so the tool is run from the directory with the 'model' and 'texture' folders.
+*/
+
+int main(int argc, char **argv)
+{
+    int options = 0;
+
+    // options before the directories
+    for (; argc >= 2 && strncmp(argv[1], "--", 2) == 0; argc--, argv++)
+    {
+        if (strcmp(argv[1], "--weld") == 0)
+            options |= EXPORT_WELD;
+        else if (strcmp(argv[1], "--optimize") == 0)
+            options |= EXPORT_OPTIMIZE;
+        else if (strcmp(argv[1], "--archive-index") == 0)
+            CFileCache::getInst()->setArchiveIndexFiles(true);
+        else
+            argc = 0; // (unknown option: print the usage)
+    }
+
+    if (argc < 3)
+    {
+        std::cout << "Usage:\n"
+                  << "  exporter [--weld] [--optimize] [--archive-index] <model directory> <output directory> [threads]" << std::endl;
+        return 1;
+    }
+
+    int threadCount = (argc >= 4 ? atoi(argv[3]) : (int)std::thread::hardware_concurrency());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int failed = ExportDirectoryToGLB(argv[1], argv[2], std::max(threadCount, 1), options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[Export] Done in " << seconds << " s." << std::endl;
+    return failed ? 1 : 0;
+}
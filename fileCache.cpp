@@ -0,0 +1,191 @@
+#include <iostream>
+#include "fileCache.h"
+#include "resFileManager.h"
+
+// default byte budget of the cache
+#define FILE_CACHE_DEFAULT_BUDGET (256L * 1024 * 1024)
+
+long CCachedFile::getSize() const
+{
+    long size = sizeof(CCachedFile) + Data.Size;
+
+    for (size_t i = 0; i < Data.StringStorage.size(); ++i)
+        size += sizeof(std::string) + Data.StringStorage[i].capacity();
+
+    return size;
+}
+
+CFileCache *CFileCache::getInst()
+{
+    static CFileCache instance;
+    return &instance;
+}
+
+CFileCache::CFileCache()
+    : Budget(FILE_CACHE_DEFAULT_BUDGET), UsedBytes(0), ArchiveIndexFiles(false)
+{
+    pthread_mutex_init(&Mutex, NULL);
+
+    // freeing a cached file releases its related file, so the manager must be created first (and destroyed after the cache)
+    CResFileManager::getInst();
+}
+
+CFileCache::~CFileCache()
+{
+    clear();
+    pthread_mutex_destroy(&Mutex);
+}
+
+CCachedFile *CFileCache::load(const char *archivePath, const char *entryName, bool indexFile)
+{
+    IReadResFile *archiveFile = createMappedReadFile(archivePath); // map outer .bdae archive file into memory
+
+    if (!archiveFile)
+        return NULL;
+
+    // (the reader is created, used and released by this thread only: the prebuilt libio counts its references non-atomically, see ResReferenceCounted.h)
+    // The entries are looked up through the hash index of the indexed reader, which is passed on as that type (its lookups hide the non-virtual ones of CPackPatchReader). With an index file, the file list is mapped from <archive>.idx, which the reader writes again if it is missing or stale.
+    CIndexedPackPatchReader *archive; // outer .bdae archive file (the reader grabs the mapped file)
+
+    if (indexFile)
+        archive = new CIndexedPackPatchReader(archiveFile, true, false, (std::string(archivePath) + ".idx").c_str());
+    else
+        archive = new CIndexedPackPatchReader(archiveFile, true, false);
+
+    IReadResFile *file = archive->openFileView(entryName); // open inner .bdae file (stored entries are not copied out of the mapping, deflated ones are decoded in one pass into a buffer that File::Init then uses in place)
+    archiveFile->drop();
+
+    CCachedFile *cachedFile = NULL;
+
+    if (file)
+    {
+        cachedFile = new CCachedFile;
+
+        // run the parser (the related file is searched in the same archive first; the archive is passed to the lookup rather than registered with the manager, so the files of other threads never see it)
+        if (cachedFile->Data.Init(file, archive) != 0)
+        {
+            cachedFile->drop();
+            cachedFile = NULL;
+        }
+
+        file->drop();
+    }
+
+    archive->drop();
+    return cachedFile;
+}
+
+CCachedFile *CFileCache::get(const char *archivePath, const char *entryName)
+{
+    if (!archivePath || !entryName)
+        return NULL;
+
+    std::string key = std::string(archivePath) + '|' + entryName;
+
+    // 1. Return the cached file and move it to the front of the LRU list.
+    pthread_mutex_lock(&Mutex);
+
+    std::map<std::string, Entry>::iterator it = Files.find(key);
+
+    if (it != Files.end())
+    {
+        Lru.splice(Lru.begin(), Lru, it->second.LruPosition);
+
+        CCachedFile *cachedFile = it->second.CachedFile;
+        cachedFile->grab();
+
+        pthread_mutex_unlock(&Mutex);
+        return cachedFile;
+    }
+
+    pthread_mutex_unlock(&Mutex);
+
+    // 2. Load the file without holding the lock.
+    File::Log() << "[CFileCache] " << key << " is not cached, loading.." << std::endl;
+
+    CCachedFile *cachedFile = load(archivePath, entryName, ArchiveIndexFiles);
+
+    if (!cachedFile)
+        return NULL;
+
+    // 3. Insert it, unless another thread has loaded the same file meanwhile (then that one is used).
+    pthread_mutex_lock(&Mutex);
+
+    it = Files.find(key);
+
+    if (it != Files.end())
+    {
+        cachedFile->drop();
+        cachedFile = it->second.CachedFile;
+        Lru.splice(Lru.begin(), Lru, it->second.LruPosition);
+    }
+    else
+    {
+        Entry entry;
+        entry.CachedFile = cachedFile;
+        entry.LruPosition = Lru.insert(Lru.begin(), key);
+        Files[key] = entry;
+
+        UsedBytes += cachedFile->getSize();
+    }
+
+    // one reference for the caller (the reference from new belongs to the cache), taken before evicting, so the file stays alive even if the cache drops it at once
+    cachedFile->grab();
+    evict();
+
+    pthread_mutex_unlock(&Mutex);
+    return cachedFile;
+}
+
+void CFileCache::evict()
+{
+    // (a file that is larger than the budget is dropped too, e.g. with a budget of 0 nothing is kept; its users still hold their references)
+    while (UsedBytes > Budget && !Lru.empty())
+    {
+        std::map<std::string, Entry>::iterator it = Files.find(Lru.back());
+
+        UsedBytes -= it->second.CachedFile->getSize();
+        it->second.CachedFile->drop();
+
+        Files.erase(it);
+        Lru.pop_back();
+    }
+}
+
+void CFileCache::setBudget(long bytes)
+{
+    pthread_mutex_lock(&Mutex);
+    Budget = bytes;
+    evict();
+    pthread_mutex_unlock(&Mutex);
+}
+
+long CFileCache::getBudget()
+{
+    pthread_mutex_lock(&Mutex);
+    long budget = Budget;
+    pthread_mutex_unlock(&Mutex);
+    return budget;
+}
+
+long CFileCache::getUsedBytes()
+{
+    pthread_mutex_lock(&Mutex);
+    long usedBytes = UsedBytes;
+    pthread_mutex_unlock(&Mutex);
+    return usedBytes;
+}
+
+void CFileCache::clear()
+{
+    pthread_mutex_lock(&Mutex);
+
+    for (std::map<std::string, Entry>::iterator it = Files.begin(); it != Files.end(); ++it)
+        it->second.CachedFile->drop();
+
+    Files.clear();
+    Lru.clear();
+    UsedBytes = 0;
+
+    pthread_mutex_unlock(&Mutex);
+}
@@ -0,0 +1,87 @@
+#ifndef __FILECACHE_H_INCLUDED__
+#define __FILECACHE_H_INCLUDED__
+
+#include <list>
+#include <map>
+#include <string>
+#include <pthread.h>
+#include "resFile.h"
+#include "libs/io/ResReferenceCounted.h"
+
+/*
+    Parsed .bdae file shared through CFileCache. It is reference counted (grab() / drop()) and read only: all its users see the same parsed data, which is freed when the last of them (the cache included) drops it.
+*/
+
+class CCachedFile : public IResReferenceCounted
+{
+public:
+    const File &getFile() const { return Data; }
+
+    // number of bytes the parsed file takes in memory (as counted against the budget of the cache)
+    long getSize() const;
+
+private:
+    friend class CFileCache;
+
+    CCachedFile() {}
+
+    virtual ~CCachedFile() { Data.Free(); }
+
+    File Data;
+};
+
+/*
+    Process-wide cache of parsed .bdae files, keyed by archive path + entry name, so that a file which is requested again (revisiting a model in the viewer, repeated references in batch tools) is not read and parsed again.
+    The cache keeps the most recently used files within a byte budget; when it is exceeded, the least recently used files are dropped by the cache (a file that is still used elsewhere stays alive until its users drop it).
+    ________________________________________________________________________________________________________________________________________________________
+*/
+
+class CFileCache
+{
+public:
+    static CFileCache *getInst();
+
+    // returns the parsed entry of the archive, loading it if it isn't cached; the file is grabbed for the caller, who must drop() it (NULL if the entry can't be opened or parsed)
+    CCachedFile *get(const char *archivePath, const char *entryName);
+
+    // sets the maximum number of bytes of cached files, evicting files if needed
+    void setBudget(long bytes);
+
+    long getBudget();
+
+    // number of bytes of the cached files
+    long getUsedBytes();
+
+    // drops all cached files
+    void clear();
+
+    // keeps the file list of each archive in an index file next to it (<archive>.idx), so that an archive opened again, by this run or a later one, is mapped instead of scanned (off by default; set it before files are requested from other threads)
+    void setArchiveIndexFiles(bool enabled) { ArchiveIndexFiles = enabled; }
+
+private:
+    struct Entry
+    {
+        CCachedFile *CachedFile;
+        std::list<std::string>::iterator LruPosition;
+    };
+
+    CFileCache();
+
+    ~CFileCache();
+
+    // opens the archive (through its index file if indexFile is set) and parses its entry
+    static CCachedFile *load(const char *archivePath, const char *entryName, bool indexFile);
+
+    // drops the least recently used files until the cache fits in its budget (the lock must be held)
+    void evict();
+
+    std::map<std::string, Entry> Files;
+    std::list<std::string> Lru; // keys of the cached files, most recently used first
+    long Budget;
+    long UsedBytes;
+    bool ArchiveIndexFiles;
+
+    pthread_mutex_t Mutex;
+};
+
+#endif
@@ -0,0 +1,478 @@
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <pthread.h>
+#include "gltfExport.h"
+#include "fileCache.h"
+#include "modelView.h"
+#include "vertexFormat.h"
+#include "textureNames.h"
+#include "meshOptimize.h"
+
+// glTF constants
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_FLOAT 5126
+#define GLTF_ARRAY_BUFFER 34962
+#define GLTF_ELEMENT_ARRAY_BUFFER 34963
+
+// maximum byteStride of a glTF bufferView (a stride must also be a multiple of 4)
+#define GLTF_MAX_STRIDE 252
+
+// binary buffer of the .glb with the JSON descriptions of its bufferViews and accessors
+struct GLBBuilder
+{
+    std::vector<char> Buffer;
+    std::ostringstream BufferViews;
+    std::ostringstream Accessors;
+    int BufferViewCount;
+    int AccessorCount;
+
+    GLBBuilder() : BufferViewCount(0), AccessorCount(0)
+    {
+        BufferViews.precision(9);
+        Accessors.precision(9);
+    }
+
+    // appends the data to the buffer (4-byte aligned) as a new bufferView and returns its index; byteStride 0 means tightly packed
+    int addBufferView(const void *data, size_t size, int byteStride, int target)
+    {
+        size_t offset = Buffer.size();
+        Buffer.insert(Buffer.end(), static_cast<const char *>(data), static_cast<const char *>(data) + size);
+        Buffer.resize((Buffer.size() + 3) & ~(size_t)3, 0);
+
+        BufferViews << (BufferViewCount ? "," : "") << "{\"buffer\":0,\"byteOffset\":" << offset << ",\"byteLength\":" << size;
+
+        if (byteStride)
+            BufferViews << ",\"byteStride\":" << byteStride;
+
+        BufferViews << ",\"target\":" << target << "}";
+        return BufferViewCount++;
+    }
+
+    // adds an accessor and returns its index; minMax is the JSON of its "min" / "max" properties, if any (required for positions)
+    int addAccessor(int bufferView, size_t byteOffset, int componentType, bool normalized, int count, const char *type, const std::string &minMax = std::string())
+    {
+        Accessors << (AccessorCount ? "," : "") << "{\"bufferView\":" << bufferView << ",\"byteOffset\":" << byteOffset
+                  << ",\"componentType\":" << componentType << (normalized ? ",\"normalized\":true" : "")
+                  << ",\"count\":" << count << ",\"type\":\"" << type << "\"" << minMax << "}";
+        return AccessorCount++;
+    }
+};
+
+// "min" / "max" JSON of 3 components
+template <typename T>
+static std::string MinMax3(const T *minimum, const T *maximum)
+{
+    std::ostringstream json;
+    json.precision(9);
+    json << ",\"min\":[" << +minimum[0] << "," << +minimum[1] << "," << +minimum[2] << "],\"max\":[" << +maximum[0] << "," << +maximum[1] << "," << +maximum[2] << "]";
+    return json.str();
+}
+
+// bounds of the 3 components of type T at the offset of each vertex
+template <typename T>
+static std::string ComputeMinMax3(const unsigned char *data, int stride, int offset, int vertexCount)
+{
+    T minimum[3], maximum[3];
+
+    for (int i = 0; i < vertexCount; i++)
+    {
+        T value[3];
+        memcpy(value, data + i * stride + offset, sizeof(value));
+
+        for (int c = 0; c < 3; c++)
+        {
+            minimum[c] = (i == 0 ? value[c] : std::min(minimum[c], value[c]));
+            maximum[c] = (i == 0 ? value[c] : std::max(maximum[c], value[c]));
+        }
+    }
+
+    return MinMax3(minimum, maximum);
+}
+
+// relative URI of a file (percent-encoded, '/' as separator)
+static std::string MakeURI(const std::string &path, const std::filesystem::path &fromDirectory)
+{
+    std::string relative = std::filesystem::absolute(path).lexically_relative(fromDirectory).generic_string();
+    std::string uri;
+
+    for (size_t i = 0; i < relative.size(); i++)
+    {
+        unsigned char c = relative[i];
+
+        if (isalnum(c) || strchr("-._~/", c))
+            uri += c;
+        else
+        {
+            char escaped[4];
+            snprintf(escaped, sizeof(escaped), "%%%02X", c);
+            uri += escaped;
+        }
+    }
+
+    return uri;
+}
+
+//! Writes a parsed model as a .glb file.
+// ______________________________________
+
+int ExportGLB(const File &file, const std::vector<std::string> &textureNames, int textureCount, const char *outputPath, int options, size_t *bytesSaved)
+{
+    ModelView model(file);
+    GLBBuilder glb;
+
+    if (!model.IsValid())
+    {
+        std::cerr << "[Export] Error: the meshes of the model lie outside of its data, the file is damaged." << std::endl;
+        return 1;
+    }
+
+    std::ostringstream meshes, nodes;
+    nodes.precision(9);
+    int meshCount = 0;
+    int submesh = 0; // index of the submesh among all submeshes of the model
+
+    textureCount = std::min<int>(textureCount, (int)textureNames.size());
+
+    // 1. Meshes: one bufferView with the vertex chunk, one per submesh with its index chunk.
+    for (int i = 0; i < model.GetMeshCount(); i++)
+    {
+        const MeshMetadata &mesh = model.GetMesh(i);
+        ChunkData vertexData = model.GetVertexData(i);
+        int firstSubmesh = submesh;
+        submesh += mesh.SubmeshCount;
+
+        if (mesh.VertexCount <= 0 || vertexData.Size < (unsigned int)mesh.VertexCount)
+            continue;
+
+        int stride = vertexData.Size / mesh.VertexCount;
+
+        // index data of the submeshes (whole triangles only)
+        std::vector<std::vector<unsigned short>> submeshIndices(mesh.SubmeshCount);
+
+        for (int k = 0; k < mesh.SubmeshCount; k++)
+        {
+            ChunkData indexData = model.GetIndexData(i, k);
+            submeshIndices[k].resize(indexData.Size / (3 * sizeof(unsigned short)) * 3);
+
+            if (!submeshIndices[k].empty())
+                memcpy(&submeshIndices[k][0], indexData.Data, submeshIndices[k].size() * sizeof(unsigned short));
+        }
+
+        // welding and optimization move whole vertices of the chunk, so their encoding stays the same
+        std::vector<unsigned char> optimizedVertices;
+        int vertexCount = mesh.VertexCount;
+
+        if ((options & (EXPORT_WELD | EXPORT_OPTIMIZE)) && mesh.SubmeshCount > 0)
+        {
+            optimizedVertices.assign(vertexData.Data, vertexData.Data + (size_t)stride * mesh.VertexCount);
+            vertexData.Data = &optimizedVertices[0];
+
+            if (options & EXPORT_WELD)
+            {
+                vertexCount = WeldVertices(&optimizedVertices[0], stride, mesh.VertexCount, &submeshIndices[0], mesh.SubmeshCount);
+
+                if (bytesSaved)
+                    *bytesSaved += (size_t)(mesh.VertexCount - vertexCount) * stride;
+            }
+
+            if ((options & EXPORT_OPTIMIZE) && !OptimizeMesh(&optimizedVertices[0], stride, vertexCount, &submeshIndices[0], mesh.SubmeshCount))
+                std::cerr << "[Export] Warning: mesh " << i + 1 << " of " << outputPath << " has indices out of range, not optimized." << std::endl;
+        }
+
+        VertexFormat format = GetFloatVertexFormat(stride);
+
+        if (stride < GetVertexFormatSize(format))
+        {
+            std::cerr << "[Export] Warning: mesh " << i + 1 << " of " << outputPath << ": " << stride << " bytes per vertex is too small for its vertex format, skipped." << std::endl;
+            continue;
+        }
+
+        // the chunk is used as it is if glTF accepts its stride; otherwise the vertices are decoded into tightly packed floats
+        bool rawStride = (stride % 4 == 0 && stride <= GLTF_MAX_STRIDE);
+        std::vector<float> decoded;
+        int position, normal, texCoord;
+
+        if (rawStride)
+        {
+            int view = glb.addBufferView(vertexData.Data, (size_t)stride * vertexCount, stride, GLTF_ARRAY_BUFFER);
+
+            position = glb.addAccessor(view, format.Position.Offset, GLTF_FLOAT, false, vertexCount, "VEC3", ComputeMinMax3<float>(vertexData.Data, stride, format.Position.Offset, vertexCount));
+            normal = glb.addAccessor(view, format.Normal.Offset, GLTF_FLOAT, false, vertexCount, "VEC3");
+            texCoord = glb.addAccessor(view, format.TexCoord.Offset, GLTF_FLOAT, false, vertexCount, "VEC2");
+        }
+        else
+        {
+            decoded.resize((size_t)vertexCount * DECODED_VERTEX_SIZE);
+            DecodeVertices(format, vertexData.Data, vertexCount, &decoded[0]);
+
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(&decoded[0]);
+            int decodedStride = DECODED_VERTEX_SIZE * sizeof(float);
+            int view = glb.addBufferView(data, decoded.size() * sizeof(float), decodedStride, GLTF_ARRAY_BUFFER);
+
+            position = glb.addAccessor(view, 0, GLTF_FLOAT, false, vertexCount, "VEC3", ComputeMinMax3<float>(data, decodedStride, 0, vertexCount));
+            normal = glb.addAccessor(view, 3 * sizeof(float), GLTF_FLOAT, false, vertexCount, "VEC3");
+            texCoord = glb.addAccessor(view, 6 * sizeof(float), GLTF_FLOAT, false, vertexCount, "VEC2");
+        }
+
+        // one primitive per submesh
+        std::ostringstream primitives;
+        int primitiveCount = 0;
+
+        for (int k = 0; k < mesh.SubmeshCount; k++)
+        {
+            int indexCount = submeshIndices[k].size();
+
+            if (indexCount == 0)
+                continue;
+
+            int view = glb.addBufferView(&submeshIndices[k][0], indexCount * sizeof(unsigned short), 0, GLTF_ELEMENT_ARRAY_BUFFER);
+            int indices = glb.addAccessor(view, 0, GLTF_UNSIGNED_SHORT, false, indexCount, "SCALAR");
+
+            primitives << (primitiveCount++ ? "," : "") << "{\"attributes\":{\"POSITION\":" << position << ",\"NORMAL\":" << normal << ",\"TEXCOORD_0\":" << texCoord << "},\"indices\":" << indices;
+
+            // the same texture assignment as in the viewer: a texture per submesh if there are as many, otherwise the first texture for all of them
+            if (textureCount > 0)
+                primitives << ",\"material\":" << (textureCount == model.GetSubmeshCount() ? firstSubmesh + k : 0);
+
+            primitives << "}";
+        }
+
+        if (primitiveCount == 0)
+            continue;
+
+        meshes << (meshCount ? "," : "") << "{\"primitives\":[" << primitives.str() << "]}";
+        nodes << (meshCount ? "," : "") << "{\"mesh\":" << meshCount << "}";
+        meshCount++;
+    }
+
+    // 2. Materials: one per texture, referencing the texture file next to the .glb.
+    std::ostringstream materials, textures, images;
+    std::filesystem::path outputDirectory = std::filesystem::absolute(outputPath).parent_path();
+
+    for (int i = 0; i < textureCount; i++)
+    {
+        materials << (i ? "," : "") << "{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":" << i << "},\"metallicFactor\":0}}";
+        textures << (i ? "," : "") << "{\"source\":" << i << "}";
+        images << (i ? "," : "") << "{\"uri\":\"" << MakeURI(textureNames[i], outputDirectory) << "\"}";
+    }
+
+    // 3. JSON description.
+    std::ostringstream json;
+    json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"bdae exporter\"}";
+    json << ",\"scene\":0,\"scenes\":[{\"nodes\":[";
+
+    for (int i = 0; i < meshCount; i++)
+        json << (i ? "," : "") << i;
+
+    json << "]}]";
+
+    if (meshCount)
+        json << ",\"nodes\":[" << nodes.str() << "],\"meshes\":[" << meshes.str() << "]";
+
+    if (textureCount)
+        json << ",\"materials\":[" << materials.str() << "],\"textures\":[" << textures.str() << "],\"images\":[" << images.str() << "]";
+
+    if (glb.BufferViewCount)
+        json << ",\"buffers\":[{\"byteLength\":" << glb.Buffer.size() << "}],\"bufferViews\":[" << glb.BufferViews.str() << "],\"accessors\":[" << glb.Accessors.str() << "]";
+
+    json << "}";
+
+    // 4. Write the .glb: header, JSON chunk (padded with spaces), BIN chunk (padded with zeros).
+    std::string jsonChunk = json.str();
+    jsonChunk.resize((jsonChunk.size() + 3) & ~(size_t)3, ' ');
+
+    unsigned int jsonChunkHeader[2] = {(unsigned int)jsonChunk.size(), 0x4E4F534A};   // 'JSON'
+    unsigned int binChunkHeader[2] = {(unsigned int)glb.Buffer.size(), 0x004E4942}; // 'BIN\0'
+    unsigned int length = 12 + 8 + jsonChunk.size() + (glb.Buffer.empty() ? 0 : 8 + glb.Buffer.size());
+    unsigned int header[3] = {0x46546C67, 2, length}; // 'glTF', version 2
+
+    FILE *out = fopen(outputPath, "wb");
+
+    if (!out)
+    {
+        std::cerr << "[Export] Error: can't create " << outputPath << std::endl;
+        return 1;
+    }
+
+    bool written = fwrite(header, sizeof(header), 1, out) == 1 &&
+                   fwrite(jsonChunkHeader, sizeof(jsonChunkHeader), 1, out) == 1 &&
+                   fwrite(jsonChunk.data(), jsonChunk.size(), 1, out) == 1;
+
+    if (written && !glb.Buffer.empty())
+        written = fwrite(binChunkHeader, sizeof(binChunkHeader), 1, out) == 1 && fwrite(&glb.Buffer[0], glb.Buffer.size(), 1, out) == 1;
+
+    written = (fclose(out) == 0) && written;
+
+    if (!written)
+    {
+        std::cerr << "[Export] Error: can't write " << outputPath << std::endl;
+        remove(outputPath);
+        return 1;
+    }
+
+    return 0;
+}
+
+// state shared by the export threads
+struct ExportJob
+{
+    const std::vector<std::string> *Paths;
+    std::string ModelDirectory;
+    std::string OutputDirectory;
+    std::atomic<size_t> Next; // next model to export
+    std::atomic<int> Failed;
+    std::atomic<int> Skipped; // models with only the quantized variant
+    int Options;
+    std::atomic<size_t> BytesSaved; // vertex data removed by welding
+};
+
+// returns true if the archive has the entry (without parsing it)
+static bool HasEntry(const char *archivePath, const char *entryName)
+{
+    IReadResFile *archiveFile = createMappedReadFile(archivePath);
+
+    if (!archiveFile)
+        return false;
+
+    CIndexedPackPatchReader *archive = new CIndexedPackPatchReader(archiveFile, true, false);
+    bool found = (archive->findFile(entryName) >= 0);
+
+    archive->drop();
+    archiveFile->drop();
+    return found;
+}
+
+static void *ExportThread(void *arg)
+{
+    ExportJob *job = static_cast<ExportJob *>(arg);
+
+    for (size_t i = job->Next++; i < job->Paths->size(); i = job->Next++)
+    {
+        const std::string &path = (*job->Paths)[i];
+
+        // only the float variant is exported: the layout of the quantized variant is not known, so a model with only the quantized variant is skipped
+        CCachedFile *cachedFile = CFileCache::getInst()->get(path.c_str(), "little_endian_not_quantized.bdae");
+
+        if (!cachedFile)
+        {
+            if (!HasEntry(path.c_str(), "little_endian_not_quantized.bdae") && HasEntry(path.c_str(), "little_endian_quantized.bdae"))
+            {
+                std::cerr << "[Export] Warning: " << path << " has only the quantized variant, which is not exported, skipped." << std::endl;
+                job->Skipped++;
+            }
+            else
+            {
+                std::cerr << "[Export] Warning: the float variant of " << path << " could not be parsed, skipped." << std::endl;
+                job->Failed++;
+            }
+
+            continue;
+        }
+
+        const File &file = cachedFile->getFile();
+        ModelView model(file);
+
+        if (!model.IsValid())
+        {
+            std::cerr << "[Export] Warning: the meshes of " << path << " lie outside of its data (the file is damaged), skipped." << std::endl;
+            cachedFile->drop();
+            job->Failed++;
+            continue;
+        }
+
+        std::vector<std::string> textureNames;
+        int textureCount = model.GetTextureCount();
+        FindTextureNames(std::filesystem::absolute(path).string().c_str(), file, textureCount, textureNames); // (the texture subpath is found after '/model/', as for the paths from the file dialog of the viewer)
+
+        std::filesystem::path outputPath = std::filesystem::path(job->OutputDirectory) / std::filesystem::path(path).lexically_relative(job->ModelDirectory);
+        outputPath.replace_extension(".glb");
+
+        std::error_code error;
+        std::filesystem::create_directories(outputPath.parent_path(), error);
+
+        size_t bytesSaved = 0;
+
+        if (ExportGLB(file, textureNames, textureCount, outputPath.string().c_str(), job->Options, &bytesSaved) != 0)
+            job->Failed++;
+
+        job->BytesSaved += bytesSaved;
+
+        cachedFile->drop();
+    }
+
+    return NULL;
+}
+
+//! Exports all .bdae models under a directory.
+// ____________________________________________
+
+int ExportDirectoryToGLB(const char *modelDirectory, const char *outputDirectory, int threadCount, int options)
+{
+    namespace fs = std::filesystem;
+
+    // 1. Collect the models.
+    std::vector<std::string> paths;
+    std::error_code error;
+
+    for (fs::recursive_directory_iterator it(modelDirectory, fs::directory_options::skip_permission_denied, error), end; !error && it != end; it.increment(error))
+    {
+        std::string extension = it->path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+        if (it->is_regular_file() && extension == ".bdae")
+            paths.push_back(it->path().string());
+    }
+
+    if (error)
+    {
+        std::cerr << "[Export] Error: can't list " << modelDirectory << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    // 2. Export them in parallel. (the files are not kept in the cache, and the log of the parser is turned off while the threads run)
+    // Each model is loaded by one thread, with its own archive reader that no other thread sees (the readers of the prebuilt libio are not thread safe, see ResReferenceCounted.h); the paths are unique, so no archive is opened by two threads at once.
+    ExportJob job;
+    job.Paths = &paths;
+    job.ModelDirectory = modelDirectory;
+    job.OutputDirectory = outputDirectory;
+    job.Next = 0;
+    job.Failed = 0;
+    job.Skipped = 0;
+    job.Options = options;
+    job.BytesSaved = 0;
+
+    long budget = CFileCache::getInst()->getBudget();
+    CFileCache::getInst()->setBudget(0);
+    File::Quiet = true;
+
+    threadCount = std::max(1, std::min<int>(threadCount, (int)paths.size()));
+    std::vector<pthread_t> threads;
+
+    for (int i = 1; i < threadCount; ++i)
+    {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, ExportThread, &job) == 0)
+            threads.push_back(thread);
+    }
+
+    ExportThread(&job); // (the calling thread is one of the workers)
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+
+    File::Quiet = false;
+    CFileCache::getInst()->clear();
+    CFileCache::getInst()->setBudget(budget);
+
+    std::cout << "[Export] Exported " << paths.size() - job.Failed - job.Skipped << " of " << paths.size() << " models into " << outputDirectory << " (" << job.Failed << " failed, " << job.Skipped << " skipped as quantized only)." << std::endl;
+
+    if (options & EXPORT_WELD)
+        std::cout << "[Export] Welding removed " << job.BytesSaved << " bytes of vertex data." << std::endl;
+    return job.Failed;
+}
@@ -0,0 +1,25 @@
+#ifndef __GLTFEXPORT_H_INCLUDED__
+#define __GLTFEXPORT_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include "resFile.h"
+
+/*
+    Export of parsed .bdae models to binary glTF 2.0 (.glb).
+    The vertex and index chunks of the model are stored in the binary buffer as they are, one bufferView per chunk (the vertex chunks keep their interleaved layout and stride), so nothing is re-encoded; each submesh becomes a primitive of its mesh.
+    Only the not quantized (float) variant is exported. Models that have only the quantized variant are skipped (and counted as such), as the layout of that variant is not known.
+    ________________________________________________________________________________________________________________________________________
+*/
+
+// export options
+#define EXPORT_WELD 1     // merge the bit-identical vertices of each mesh (see WeldVertices())
+#define EXPORT_OPTIMIZE 2 // reorder the triangles and vertices of each mesh for the GPU (see OptimizeMesh())
+
+// writes a parsed model as a .glb file; textureNames are the texture files of the model (paths relative to the working directory, see FindTextureNames()), of which the first textureCount are used by its submeshes; options are EXPORT_* flags; the bytes of vertex data removed by welding are added to bytesSaved, if given; returns 0 on success
+int ExportGLB(const File &file, const std::vector<std::string> &textureNames, int textureCount, const char *outputPath, int options = 0, size_t *bytesSaved = 0);
+
+// exports every .bdae model under the model directory into the output directory (same subpaths, .glb extension) with threadCount threads; returns the number of models that failed (skipped quantized-only models are not counted)
+int ExportDirectoryToGLB(const char *modelDirectory, const char *outputDirectory, int threadCount, int options = 0);
+
+#endif
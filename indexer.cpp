@@ -0,0 +1,79 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include "stringIndex.h"
+#include "fileCache.h"
+
+/*
+    Command line tool for the string index:
+
+    indexer build [--archive-index] <model directory> <index file> [threads]   – indexes the strings of all .bdae models under the directory
+    indexer query <index file> <string> [<string> ..]                          – prints the models that use each string ('prefix*' matches every string with the prefix)
+
+    --archive-index  keeps the file list of each model archive in an index file next to it (<model>.bdae.idx), so that later runs map it instead of scanning the archive
+*/
+
+static int printUsage()
+{
+    std::cout << "Usage:\n"
+              << "  indexer build [--archive-index] <model directory> <index file> [threads]\n"
+              << "  indexer query <index file> <string> [<string> ..]   (a string ending with '*' is a prefix query)" << std::endl;
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "build") == 0)
+    {
+        int arg = 2; // first argument after the options
+
+        if (strcmp(argv[arg], "--archive-index") == 0)
+        {
+            CFileCache::getInst()->setArchiveIndexFiles(true);
+            arg++;
+        }
+
+        if (argc < arg + 2)
+            return printUsage();
+
+        int threadCount = (argc >= arg + 3 ? atoi(argv[arg + 2]) : (int)std::thread::hardware_concurrency());
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int result = BuildStringIndex(argv[arg], argv[arg + 1], std::max(threadCount, 1));
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "[Index] Done in " << seconds << " s." << std::endl;
+        return result;
+    }
+
+    if (argc >= 4 && strcmp(argv[1], "query") == 0)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        CStringIndex index;
+
+        if (!index.open(argv[2]))
+            return 1;
+
+        for (int i = 3; i < argc; ++i)
+        {
+            std::vector<unsigned int> models;
+            index.find(argv[i], models);
+
+            std::cout << "\"" << argv[i] << "\": " << models.size() << " model(s)" << std::endl;
+
+            for (size_t j = 0; j < models.size(); ++j)
+                std::cout << "  " << index.getModelName(models[j]) << std::endl;
+        }
+
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "[Index] " << index.getStringCount() << " strings, " << index.getModelCount() << " models, answered in " << milliseconds << " ms." << std::endl;
+        return 0;
+    }
+
+    return printUsage();
+}
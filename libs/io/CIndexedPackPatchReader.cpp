@@ -0,0 +1,75 @@
+#include "CIndexedPackPatchReader.h"
+#include "PackIndexCache.h"
+
+CIndexedPackPatchReader::CIndexedPackPatchReader(const char* filename, bool ignoreCase, bool ignorePaths)
+	: CPackPatchReader(filename, ignoreCase, ignorePaths), IndexFile(0)
+{
+	Index.build(m_fileList);
+}
+
+CIndexedPackPatchReader::CIndexedPackPatchReader(IReadResFile* file, bool ignoreCase, bool ignorePaths)
+	: CPackPatchReader(file, ignoreCase, ignorePaths), IndexFile(0)
+{
+	Index.build(m_fileList);
+}
+
+CIndexedPackPatchReader::CIndexedPackPatchReader(IReadResFile* file, bool ignoreCase, bool ignorePaths, const char* indexFileName)
+	: CPackPatchReader((IReadResFile*)0, ignoreCase, ignorePaths), IndexFile(0)
+{
+	if (!file)
+		return;
+
+	CPackIndexCache cache;
+
+	if (cache.load(indexFileName, file->getFileName()) && cache.getIndex(Index))
+	{
+		attachFile(file, false);
+		cache.getEntries(m_fileList);
+		m_fileNb = (int)m_fileList.size();
+
+		IndexFile = cache.getFile();
+		IndexFile->grab();
+		return;
+	}
+
+	attachFile(file, true);
+	Index.build(m_fileList);
+	CPackIndexCache::write(indexFileName, file->getFileName(), m_fileList, Index);
+}
+
+CIndexedPackPatchReader::~CIndexedPackPatchReader()
+{
+	// the entries of the main pack point into the index file
+	m_fileList.clear();
+
+	if (IndexFile)
+		IndexFile->drop();
+}
+
+IReadResFile* CIndexedPackPatchReader::openFile(const char* filename)
+{
+	int32 index = findFile(filename);
+
+	if (index == -1)
+		return 0;
+
+	return CPackPatchReader::openFile(index);
+}
+
+IReadResFile* CIndexedPackPatchReader::openFileView(const char* filename)
+{
+	int32 index = findFile(filename);
+
+	if (index == -1)
+		return 0;
+
+	return CPackPatchReader::openFileView(index);
+}
+
+bool CIndexedPackPatchReader::addPackPatchFile(const char* filename, bool ignoreCase, bool ignorePaths)
+{
+	bool added = CPackPatchReader::addPackPatchFile(filename, ignoreCase, ignorePaths);
+
+	Index.build(m_fileList);
+	return added;
+}
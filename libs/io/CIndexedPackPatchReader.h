@@ -0,0 +1,51 @@
+#pragma once
+#ifndef __C_INDEXED_PACK_PATCH_READER_H_INCLUDED__
+#define __C_INDEXED_PACK_PATCH_READER_H_INCLUDED__
+
+#include "PackPatchReader.h"
+#include "PackFileIndex.h"
+
+/*!
+	Pack patch reader that looks files up through a hash index instead of a binary search.
+	Patches are merged into the main file list when they are added (a patched entry redirects
+	to its patch), so the index over the main list covers every layer with the precedence
+	already resolved; it is rebuilt each time a patch is added.
+	The lookups hide the non-virtual ones of CPackPatchReader, so the reader must be used
+	through this type (a CPackPatchReader pointer to it would search without the index).
+*/
+class CIndexedPackPatchReader : public CPackPatchReader
+{
+public:
+	CIndexedPackPatchReader(const char* filename, bool ignoreCase, bool ignorePaths);
+
+	CIndexedPackPatchReader(IReadResFile* file, bool ignoreCase, bool ignorePaths);
+
+	//! opens a pack through an index file (see CPackIndexCache) instead of scanning it
+	/** If the index file is missing or does not match the pack, the pack is scanned and the
+	index file is written again.
+	\param indexFileName Index file, usually the name of the pack with ".idx" appended. */
+	CIndexedPackPatchReader(IReadResFile* file, bool ignoreCase, bool ignorePaths, const char* indexFileName);
+
+	virtual ~CIndexedPackPatchReader();
+
+	//! opens a file by file name
+	virtual IReadResFile* openFile(const char* filename);
+
+	//! opens a file by file name, without copying stored entries of a memory mapped pack
+	IReadResFile* openFileView(const char* filename);
+
+	//! adds a patch pack and rebuilds the index
+	virtual bool addPackPatchFile(const char* filename, bool ignoreCase = true, bool ignorePaths = true);
+
+	//! returns fileindex, or -1 if there is no such file
+	int32 findFile(const char* filename) const
+	{
+		return Index.find(m_fileList, filename);
+	}
+
+protected:
+	CPackFileIndex Index;
+	IReadResFile* IndexFile; // mapped index file holding the names of the main pack, 0 if the pack was scanned
+};
+
+#endif
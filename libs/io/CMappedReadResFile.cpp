@@ -0,0 +1,224 @@
+#include "CMappedReadResFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+void* const CMappedReadResFile::INVALID_FILE_HANDLE = INVALID_HANDLE_VALUE;
+#endif
+
+CMappedReadResFile::CMappedReadResFile(const char* fileName)
+	: Root(this), FileHandle(INVALID_FILE_HANDLE),
+#ifdef _WIN32
+	MappingHandle(0),
+#endif
+	FileName(fileName ? fileName : ""), MapBase(0), MapLength(0), Data(0), ViewOffset(0), FileSize(0), Pos(0)
+{
+	if (!fileName)
+		return;
+
+#ifdef _WIN32
+	FileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (FileHandle == INVALID_FILE_HANDLE)
+		return;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(FileHandle, &size);
+	FileSize = (long)size.QuadPart;
+
+	if (FileSize > 0)
+		MappingHandle = CreateFileMappingA(FileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+#else
+	FileHandle = open(fileName, O_RDONLY);
+	if (FileHandle == INVALID_FILE_HANDLE)
+		return;
+
+	struct stat st;
+	if (fstat(FileHandle, &st) == 0)
+		FileSize = (long)st.st_size;
+#endif
+
+	map(0, FileSize);
+}
+
+CMappedReadResFile::CMappedReadResFile(const CMappedReadResFile* root, long offset, long size, const char* fileName)
+	: Root(root), FileHandle(INVALID_FILE_HANDLE),
+#ifdef _WIN32
+	MappingHandle(0),
+#endif
+	FileName(fileName ? fileName : ""), MapBase(0), MapLength(0), Data(0), ViewOffset(offset), FileSize(size), Pos(0)
+{
+	Root->grab();
+	map(offset, size);
+}
+
+CMappedReadResFile::~CMappedReadResFile()
+{
+	if (MapBase)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(MapBase);
+#else
+		munmap(MapBase, MapLength);
+#endif
+	}
+
+	if (Root != this)
+	{
+		Root->drop();
+		return;
+	}
+
+#ifdef _WIN32
+	if (MappingHandle)
+		CloseHandle(MappingHandle);
+	if (FileHandle != INVALID_FILE_HANDLE)
+		CloseHandle(FileHandle);
+#else
+	if (FileHandle != INVALID_FILE_HANDLE)
+		close(FileHandle);
+#endif
+}
+
+void CMappedReadResFile::map(long offset, long size)
+{
+	if (size <= 0)
+		return;
+
+	// the mapping must start on a page (allocation granularity) boundary
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	long alignment = (long)info.dwAllocationGranularity;
+#else
+	long alignment = sysconf(_SC_PAGESIZE);
+#endif
+	long mapOffset = offset - offset % alignment;
+	MapLength = (size_t)(size + (offset - mapOffset));
+
+#ifdef _WIN32
+	if (!Root->MappingHandle)
+		return;
+
+	MapBase = MapViewOfFile(Root->MappingHandle, FILE_MAP_COPY, (DWORD)((uint64)mapOffset >> 32), (DWORD)mapOffset, MapLength);
+#else
+	MapBase = mmap(NULL, MapLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, Root->FileHandle, mapOffset);
+	if (MapBase == MAP_FAILED)
+		MapBase = 0;
+#endif
+
+	if (MapBase)
+		Data = (char*)MapBase + (offset - mapOffset);
+}
+
+S32 CMappedReadResFile::read(void* buffer, U32 sizeToRead)
+{
+	S32 readSize = readAt(Pos, buffer, sizeToRead);
+	Pos += readSize;
+	return readSize;
+}
+
+S32 CMappedReadResFile::readAt(long pos, void* buffer, U32 sizeToRead) const
+{
+	long remaining = FileSize - pos;
+	if (pos < 0 || remaining <= 0 || !Data)
+		return 0;
+
+	if ((long)sizeToRead > remaining)
+		sizeToRead = (U32)remaining;
+
+	memcpy(buffer, Data + pos, sizeToRead);
+	return (S32)sizeToRead;
+}
+
+void CMappedReadResFile::prefetch(long pos, long size) const
+{
+	if (pos < 0 || pos >= FileSize || size <= 0 || !Data)
+		return;
+
+	if (size > FileSize - pos)
+		size = FileSize - pos;
+
+#ifndef _WIN32
+	// madvise() needs a page aligned start
+	long pageSize = sysconf(_SC_PAGESIZE);
+	char* start = Data + pos;
+	char* alignedStart = (char*)((size_t)start & ~(size_t)(pageSize - 1));
+
+	madvise(alignedStart, size + (start - alignedStart), MADV_WILLNEED);
+#endif
+}
+
+bool CMappedReadResFile::seek(long finalPos, bool relativeMovement)
+{
+	if (relativeMovement)
+		finalPos += Pos;
+
+	if (finalPos < 0 || finalPos > FileSize)
+		return false;
+
+	Pos = finalPos;
+	return true;
+}
+
+IReadResFile* CMappedReadResFile::clone() const
+{
+	CMappedReadResFile* file = new CMappedReadResFile(Root, ViewOffset, FileSize, FileName.c_str());
+	file->Pos = Pos;
+	return file;
+}
+
+long CMappedReadResFile::getSize() const
+{
+	return FileSize;
+}
+
+long CMappedReadResFile::getPos() const
+{
+	return Pos;
+}
+
+const char* CMappedReadResFile::getFileName() const
+{
+	return FileName.c_str();
+}
+
+void* CMappedReadResFile::getBuffer(long* size)
+{
+	if (size)
+		*size = FileSize;
+
+	return Data;
+}
+
+IReadResFile* CMappedReadResFile::createView(long offset, long size, const char* fileName) const
+{
+	if (offset < 0 || size < 0 || offset + size > FileSize)
+		return 0;
+
+	CMappedReadResFile* view = new CMappedReadResFile(Root, ViewOffset + offset, size, fileName);
+	if (!view->isOpen())
+	{
+		view->drop();
+		return 0;
+	}
+
+	return view;
+}
+
+IReadResFile* createMappedReadFile(const char* fileName)
+{
+	CMappedReadResFile* file = new CMappedReadResFile(fileName);
+	if (!file->isOpen())
+	{
+		file->drop();
+		return 0;
+	}
+
+	return file;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#ifndef __C_MAPPED_READ_RES_FILE_H_INCLUDED__
+#define __C_MAPPED_READ_RES_FILE_H_INCLUDED__
+
+#include "IPositionalReadResFile.h"
+
+/*!
+	Read-only file backed by a private memory mapping of the whole file (or of a byte range of it).
+	read() is a memcpy from the mapping, getBuffer() returns the mapping itself and isAllInMemory() is true,
+	so callers that understand in-memory sources can work on the mapped bytes directly.
+	Pages are mapped copy-on-write: writing into the buffer never touches the file on disk and never
+	affects other views of the same file.
+*/
+class CMappedReadResFile : public IPositionalReadResFile
+{
+public:
+	CMappedReadResFile(const char* fileName);
+
+	virtual ~CMappedReadResFile();
+
+	//! reads an amount of bytes from the mapping
+	virtual S32 read(void* buffer, U32 sizeToRead);
+
+	//! copies an amount of bytes at a position from the mapping
+	virtual S32 readAt(long pos, void* buffer, U32 sizeToRead) const;
+
+	//! asks the system to start reading a byte range of the mapping from disk
+	virtual void prefetch(long pos, long size) const;
+
+	//! changes position in file, returns true if successful
+	virtual bool seek(long finalPos, bool relativeMovement = false);
+
+	//! creates a new private mapping of the same byte range
+	virtual IReadResFile* clone() const;
+
+	//! returns size of file (or of the mapped range for a view)
+	virtual long getSize() const;
+
+	//! returns where in the file we are
+	virtual long getPos() const;
+
+	//! returns name of file
+	virtual const char* getFileName() const;
+
+	//! returns the mapped bytes
+	virtual void* getBuffer(long* size);
+
+	virtual bool isAllInMemory() const
+	{
+		return true;
+	}
+
+	//! returns true if the file was opened and mapped successfully
+	bool isOpen() const
+	{
+		return Root->FileHandle != INVALID_FILE_HANDLE && (Data != 0 || FileSize == 0);
+	}
+
+	//! creates a separate private mapping of a byte range of this file
+	/** The view keeps the underlying file open; its bytes can be modified in place
+	without affecting this file or any other view.
+	\param offset Start of the range, relative to the start of this file or view.
+	\param size Size of the range in bytes.
+	\param fileName Name reported by the view.
+	\return The view, or 0 if the range is outside this file. */
+	IReadResFile* createView(long offset, long size, const char* fileName) const;
+
+private:
+#ifdef _WIN32
+	typedef void* FileHandleType;
+	static void* const INVALID_FILE_HANDLE;
+#else
+	typedef int FileHandleType;
+	static const int INVALID_FILE_HANDLE = -1;
+#endif
+
+	//! maps a byte range of the root file
+	CMappedReadResFile(const CMappedReadResFile* root, long offset, long size, const char* fileName);
+
+	//! creates the mapping of [offset, offset + size) of the root file
+	void map(long offset, long size);
+
+	const CMappedReadResFile* Root; // file that owns the handle; grabbed by views and clones
+	FileHandleType FileHandle;
+#ifdef _WIN32
+	FileHandleType MappingHandle;
+#endif
+	std::string FileName;
+	void* MapBase;     // start of the mapping (aligned down to the page / allocation granularity)
+	size_t MapLength;  // length of the mapping
+	char* Data;        // first byte of this file or view inside the mapping
+	long ViewOffset;   // offset of this view in the root file
+	long FileSize;
+	long Pos;
+};
+
+#endif
@@ -67,6 +67,15 @@ public:
 	//! opens a file by index
 	IReadResFile* openFile(int32 index);
 
+	//! opens a file by file name, without copying stored entries of a memory mapped pack
+	IReadResFile* openFileView(const char* filename);
+
+	//! opens a file by index, without copying stored entries of a memory mapped pack
+	/** Stored (uncompressed) entries become private mappings of their byte range
+	in the pack, deflated entries are decoded in one pass by inflateBuffer() into a
+	memory file, all other entries are opened with openFile(). */
+	IReadResFile* openFileView(int32 index);
+
 	//! returns count of files in archive
 	int32 getFileCount();
 
@@ -100,6 +109,14 @@ protected:
 	//! deletes the path from a filename
 	void deletePathFromFilename(std::string& filename);
 
+	//! reads the local header of an entry and the position of its data
+	bool readLocalHeader(int32 index, long* dataPos, SZIPResFileHeader* header);
+
+	//! sets the pack file of a reader that was constructed without one (the file is grabbed)
+	/** \param scan If true the file list is built the same way as by the constructor,
+	otherwise the caller fills m_fileList. */
+	void attachFile(IReadResFile* file, bool scan);
+
 
 //	bool IgnoreCase;  //always ignore case
 //	bool IgnorePaths;
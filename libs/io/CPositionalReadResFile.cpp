@@ -0,0 +1,160 @@
+#include "CPositionalReadResFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+void* const CPositionalReadResFile::INVALID_FILE_HANDLE = INVALID_HANDLE_VALUE;
+#endif
+
+CPositionalReadResFile::CPositionalReadResFile(const char* fileName)
+	: Root(this), FileHandle(INVALID_FILE_HANDLE), FileName(fileName ? fileName : ""), FileSize(0), Pos(0)
+{
+	if (!fileName)
+		return;
+
+#ifdef _WIN32
+	FileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (FileHandle == INVALID_FILE_HANDLE)
+		return;
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(FileHandle, &size);
+	FileSize = (long)size.QuadPart;
+#else
+	FileHandle = open(fileName, O_RDONLY);
+	if (FileHandle == INVALID_FILE_HANDLE)
+		return;
+
+	struct stat st;
+	if (fstat(FileHandle, &st) == 0)
+		FileSize = (long)st.st_size;
+#endif
+}
+
+CPositionalReadResFile::CPositionalReadResFile(const CPositionalReadResFile* root)
+	: Root(root), FileHandle(INVALID_FILE_HANDLE), FileName(root->FileName), FileSize(root->FileSize), Pos(0)
+{
+	Root->grab();
+}
+
+CPositionalReadResFile::~CPositionalReadResFile()
+{
+	if (Root != this)
+	{
+		Root->drop();
+		return;
+	}
+
+	if (FileHandle != INVALID_FILE_HANDLE)
+	{
+#ifdef _WIN32
+		CloseHandle(FileHandle);
+#else
+		close(FileHandle);
+#endif
+	}
+}
+
+S32 CPositionalReadResFile::read(void* buffer, U32 sizeToRead)
+{
+	S32 readSize = readAt(Pos, buffer, sizeToRead);
+	Pos += readSize;
+	return readSize;
+}
+
+S32 CPositionalReadResFile::readAt(long pos, void* buffer, U32 sizeToRead) const
+{
+	long remaining = FileSize - pos;
+	if (pos < 0 || remaining <= 0 || !isOpen())
+		return 0;
+
+	if ((long)sizeToRead > remaining)
+		sizeToRead = (U32)remaining;
+
+	U32 readSize = 0;
+
+	// a positional read may return less than requested, continue until all bytes are read
+	while (readSize < sizeToRead)
+	{
+#ifdef _WIN32
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		uint64 offset = (uint64)(pos + readSize);
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+		DWORD n = 0;
+		if (!ReadFile(Root->FileHandle, (char*)buffer + readSize, sizeToRead - readSize, &n, &overlapped) || n == 0)
+			break;
+#else
+		ssize_t n = pread(Root->FileHandle, (char*)buffer + readSize, sizeToRead - readSize, pos + readSize);
+		if (n <= 0)
+			break;
+#endif
+		readSize += (U32)n;
+	}
+
+	return (S32)readSize;
+}
+
+void CPositionalReadResFile::prefetch(long pos, long size) const
+{
+	if (pos < 0 || pos >= FileSize || size <= 0 || !isOpen())
+		return;
+
+#if defined(POSIX_FADV_WILLNEED)
+	posix_fadvise(Root->FileHandle, pos, size, POSIX_FADV_WILLNEED);
+#endif
+}
+
+bool CPositionalReadResFile::seek(long finalPos, bool relativeMovement)
+{
+	if (relativeMovement)
+		finalPos += Pos;
+
+	if (finalPos < 0 || finalPos > FileSize)
+		return false;
+
+	Pos = finalPos;
+	return true;
+}
+
+IReadResFile* CPositionalReadResFile::clone() const
+{
+	CPositionalReadResFile* file = new CPositionalReadResFile(Root);
+	file->Pos = Pos;
+	return file;
+}
+
+long CPositionalReadResFile::getSize() const
+{
+	return FileSize;
+}
+
+long CPositionalReadResFile::getPos() const
+{
+	return Pos;
+}
+
+const char* CPositionalReadResFile::getFileName() const
+{
+	return FileName.c_str();
+}
+
+IReadResFile* createPositionalReadFile(const char* fileName)
+{
+	CPositionalReadResFile* file = new CPositionalReadResFile(fileName);
+	if (!file->isOpen())
+	{
+		file->drop();
+		return 0;
+	}
+
+	return file;
+}
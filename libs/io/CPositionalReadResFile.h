@@ -0,0 +1,69 @@
+#pragma once
+#ifndef __C_POSITIONAL_READ_RES_FILE_H_INCLUDED__
+#define __C_POSITIONAL_READ_RES_FILE_H_INCLUDED__
+
+#include "IPositionalReadResFile.h"
+
+/*!
+	Read-only file that reads with positional reads (pread, or ReadFile at an offset on Windows)
+	instead of seeking a shared stream.
+	Every clone shares the file handle of the original and only keeps its own read position,
+	so clones are cheap, and readAt() can be used by any number of threads at once.
+*/
+class CPositionalReadResFile : public IPositionalReadResFile
+{
+public:
+	CPositionalReadResFile(const char* fileName);
+
+	virtual ~CPositionalReadResFile();
+
+	//! reads an amount of bytes from the current position
+	virtual S32 read(void* buffer, U32 sizeToRead);
+
+	//! reads an amount of bytes at a position, without moving the read position
+	virtual S32 readAt(long pos, void* buffer, U32 sizeToRead) const;
+
+	//! asks the system to start reading a byte range into the page cache
+	virtual void prefetch(long pos, long size) const;
+
+	//! changes position in file, returns true if successful
+	virtual bool seek(long finalPos, bool relativeMovement = false);
+
+	//! returns a file sharing the same handle, at the same position
+	virtual IReadResFile* clone() const;
+
+	//! returns size of file
+	virtual long getSize() const;
+
+	//! returns where in the file we are
+	virtual long getPos() const;
+
+	//! returns name of file
+	virtual const char* getFileName() const;
+
+	//! returns true if the file was opened successfully
+	bool isOpen() const
+	{
+		return Root->FileHandle != INVALID_FILE_HANDLE;
+	}
+
+private:
+#ifdef _WIN32
+	typedef void* FileHandleType;
+	static void* const INVALID_FILE_HANDLE;
+#else
+	typedef int FileHandleType;
+	static const int INVALID_FILE_HANDLE = -1;
+#endif
+
+	//! creates a clone of root
+	CPositionalReadResFile(const CPositionalReadResFile* root);
+
+	const CPositionalReadResFile* Root; // file that owns the handle; grabbed by clones
+	FileHandleType FileHandle;
+	std::string FileName;
+	long FileSize;
+	long Pos;
+};
+
+#endif
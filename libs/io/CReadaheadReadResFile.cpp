@@ -0,0 +1,152 @@
+#include "CReadaheadReadResFile.h"
+
+CReadaheadReadResFile::CReadaheadReadResFile(IReadResFile* file, long rangeSize, long windowSize)
+	: File(file), PositionalFile(dynamic_cast<IPositionalReadResFile*>(file)), RangeEnd(0), Pos(0), SourcePos(0),
+	WindowPos(0), WindowFill(0)
+{
+	if (!File)
+		return;
+
+	File->grab();
+
+	Pos = SourcePos = WindowPos = File->getPos();
+	RangeEnd = Pos + (rangeSize > 0 ? rangeSize : 0);
+	if (RangeEnd > File->getSize())
+		RangeEnd = File->getSize();
+
+	if (PositionalFile)
+		PositionalFile->prefetch(Pos, RangeEnd - Pos);
+	else
+		Window.resize(std::min(windowSize, RangeEnd - Pos));
+}
+
+CReadaheadReadResFile::~CReadaheadReadResFile()
+{
+	if (File)
+		File->drop();
+}
+
+S32 CReadaheadReadResFile::readSource(void* buffer, U32 sizeToRead)
+{
+	if (SourcePos != Pos)
+	{
+		if (!File->seek(Pos))
+			return 0;
+
+		SourcePos = Pos;
+	}
+
+	S32 readSize = File->read(buffer, sizeToRead);
+	if (readSize > 0)
+		SourcePos += readSize;
+
+	return readSize;
+}
+
+S32 CReadaheadReadResFile::read(void* buffer, U32 sizeToRead)
+{
+	if (!File)
+		return 0;
+
+	if (PositionalFile)
+	{
+		S32 readSize = PositionalFile->readAt(Pos, buffer, sizeToRead);
+		if (readSize > 0)
+			Pos += readSize;
+
+		return readSize;
+	}
+
+	char* out = (char*)buffer;
+	U32 done = 0;
+
+	while (done < sizeToRead)
+	{
+		// serve what the window holds
+		if (Pos >= WindowPos && Pos < WindowPos + WindowFill)
+		{
+			U32 copySize = (U32)std::min<long>(sizeToRead - done, WindowPos + WindowFill - Pos);
+			memcpy(out + done, &Window[Pos - WindowPos], copySize);
+			done += copySize;
+			Pos += copySize;
+			continue;
+		}
+
+		// large reads and reads past the announced range go straight to the source
+		U32 remaining = sizeToRead - done;
+		if ((long)remaining >= (long)Window.size() || Pos >= RangeEnd)
+		{
+			S32 readSize = readSource(out + done, remaining);
+			if (readSize > 0)
+			{
+				done += readSize;
+				Pos += readSize;
+			}
+			break;
+		}
+
+		// refill the window with the next part of the range
+		long fillSize = std::min<long>((long)Window.size(), RangeEnd - Pos);
+		S32 readSize = readSource(&Window[0], (U32)fillSize);
+
+		WindowPos = Pos;
+		WindowFill = (readSize > 0 ? readSize : 0);
+
+		if (WindowFill == 0)
+			break;
+	}
+
+	return (S32)done;
+}
+
+bool CReadaheadReadResFile::seek(long finalPos, bool relativeMovement)
+{
+	if (!File)
+		return false;
+
+	if (relativeMovement)
+		finalPos += Pos;
+
+	if (finalPos < 0 || finalPos > File->getSize())
+		return false;
+
+	// the window is kept, the source is only seeked when it is read again
+	Pos = finalPos;
+	return true;
+}
+
+IReadResFile* CReadaheadReadResFile::clone() const
+{
+	if (!File)
+		return 0;
+
+	IReadResFile* source = File->clone();
+	if (!source)
+		return 0;
+
+	source->seek(Pos);
+	CReadaheadReadResFile* file = new CReadaheadReadResFile(source, RangeEnd - Pos);
+	source->drop();
+
+	return file;
+}
+
+long CReadaheadReadResFile::getSize() const
+{
+	return File ? File->getSize() : 0;
+}
+
+long CReadaheadReadResFile::getPos() const
+{
+	return Pos;
+}
+
+const char* CReadaheadReadResFile::getFileName() const
+{
+	return File ? File->getFileName() : "";
+}
+
+IReadResFile* createReadaheadReadFile(IReadResFile* file, long rangeSize)
+{
+	return new CReadaheadReadResFile(file, rangeSize);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef __C_READAHEAD_READ_RES_FILE_H_INCLUDED__
+#define __C_READAHEAD_READ_RES_FILE_H_INCLUDED__
+
+#include "IPositionalReadResFile.h"
+
+/*!
+	Read-only file that reads a known byte range of another file ahead of the reader.
+	It is meant for loaders that read a file section by section with small blocking reads
+	(header, tables, body, chunks) when the extent of all sections is known up front.
+	If the source is an IPositionalReadResFile, the whole range is announced with prefetch()
+	when the wrapper is created, and reads are passed through with readAt().
+	Any other source is read in large windows: one read of the source fills the window and
+	the section reads that follow are served from it; reads that are larger than the window
+	go straight to the source.
+*/
+class CReadaheadReadResFile : public IReadResFile
+{
+public:
+	//! \param file Source file (it is grabbed), read from its current position.
+	//! \param rangeSize Number of bytes that will be read from the current position, the source is never read past this range.
+	//! \param windowSize Size of the read window for sources that are not positional.
+	CReadaheadReadResFile(IReadResFile* file, long rangeSize, long windowSize = DEFAULT_WINDOW_SIZE);
+
+	virtual ~CReadaheadReadResFile();
+
+	//! reads an amount of bytes from the file
+	virtual S32 read(void* buffer, U32 sizeToRead);
+
+	//! changes position in file, returns true if successful
+	virtual bool seek(long finalPos, bool relativeMovement = false);
+
+	//! returns a wrapper over a clone of the source, at the same position
+	virtual IReadResFile* clone() const;
+
+	//! returns size of the source file
+	virtual long getSize() const;
+
+	//! returns where in the file we are
+	virtual long getPos() const;
+
+	//! returns name of the source file
+	virtual const char* getFileName() const;
+
+	enum { DEFAULT_WINDOW_SIZE = 1024 * 1024 };
+
+private:
+	//! reads from the source at Pos, seeking it if needed
+	S32 readSource(void* buffer, U32 sizeToRead);
+
+	IReadResFile* File;
+	IPositionalReadResFile* PositionalFile; // File if it supports positional reads, else 0
+	long RangeEnd;                          // end of the announced range in the source
+	long Pos;                               // read position in the source
+	long SourcePos;                         // position of the source itself (for sources that are not positional)
+
+	std::vector<char> Window;
+	long WindowPos;                         // position of the first byte of the window in the source
+	long WindowFill;                        // number of valid bytes in the window
+};
+
+#endif
@@ -111,6 +111,13 @@ public:
 	//! opens a file by index
 	IReadResFile* openFile(int32 index);
 
+	//! opens a file by file name, without copying stored entries of a memory mapped zip
+	IReadResFile* openFileView(const char* filename);
+
+	//! opens a file by index, without copying stored entries of a memory mapped zip
+	/** Deflated entries are decoded in one pass by inflateBuffer() into a memory file. */
+	IReadResFile* openFileView(int32 index);
+
 	//! returns count of files in archive
 	int32 getFileCount();
 
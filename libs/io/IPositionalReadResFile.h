@@ -0,0 +1,28 @@
+#pragma once
+#ifndef __I_POSITIONAL_READ_RES_FILE_H_INCLUDED__
+#define __I_POSITIONAL_READ_RES_FILE_H_INCLUDED__
+
+#include "IReadResFile.h"
+
+//! Interface of files that can also be read at any position without moving the read position.
+/** readAt() does not change the file, so any number of threads can read the same file at the
+same time (for example to open different entries of one archive in parallel) without a lock. */
+class IPositionalReadResFile : public IReadResFile
+{
+public:
+	//! Reads an amount of bytes starting at a position in the file.
+	/** \param pos Position of the first byte to read.
+	\param buffer Pointer to buffer where read bytes are written to.
+	\param sizeToRead Amount of bytes to read from the file.
+	\return How much bytes were read. */
+	virtual S32 readAt(long pos, void* buffer, U32 sizeToRead) const = 0;
+
+	//! Announces that a byte range will be read soon.
+	/** The file may start loading the range in the background (readahead), so that the reads
+	that follow do not wait for the disk one after another. Does nothing by default. */
+	virtual void prefetch(long pos, long size) const
+	{
+	}
+};
+
+#endif
@@ -109,5 +109,11 @@ IReadResFile *createReadFile(const char *fileName);
 IReadResFile *createLimitReadFile(const char *fileName, IReadResFile *alreadyOpenedFile, long areaSize);
 //! Internal function, please do not use.
 IReadResFile *createMemoryReadFile(void *memory, long size, const char *fileName, bool deleteMemoryWhenDropped);
+//! Internal function, please do not use.
+IReadResFile *createMappedReadFile(const char *fileName);
+//! Internal function, please do not use.
+IReadResFile *createPositionalReadFile(const char *fileName);
+//! Internal function, please do not use.
+IReadResFile *createReadaheadReadFile(IReadResFile *file, long rangeSize);
 
 #endif
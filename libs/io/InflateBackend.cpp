@@ -0,0 +1,673 @@
+#include <string.h>
+#include <zlib.h>
+#include "InflateBackend.h"
+
+static InflateBufferFunc InflateBackend = inflateBufferFast;
+
+void setInflateBackend(InflateBufferFunc backend)
+{
+	InflateBackend = (backend ? backend : inflateBufferFast);
+}
+
+InflateBufferFunc getInflateBackend()
+{
+	return InflateBackend;
+}
+
+bool inflateBuffer(void* out, U32 outSize, const void* in, U32 inSize)
+{
+	InflateBufferFunc backend = InflateBackend;
+
+	if (backend(out, outSize, in, inSize))
+		return true;
+
+	return backend != inflateBufferZlib && inflateBufferZlib(out, outSize, in, inSize);
+}
+
+bool inflateBufferZlib(void* out, U32 outSize, const void* in, U32 inSize)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+
+	stream.next_in = (Bytef*)in;
+	stream.avail_in = inSize;
+	stream.next_out = (Bytef*)out;
+	stream.avail_out = outSize;
+
+	// raw deflate data, no zlib header
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		return false;
+
+	int err = inflate(&stream, Z_FINISH);
+	bool valid = (err == Z_STREAM_END && stream.total_out == outSize);
+
+	inflateEnd(&stream);
+	return valid;
+}
+
+// ____________________________________________________________________________
+// inflateBufferFast
+//
+// Decodes the whole stream in one call: both buffers are complete, so there is
+// no window to maintain and no state to save between calls. Huffman codes are
+// decoded with a main table indexed by the next bits of the stream and, for
+// codes longer than the main table, a second level subtable.
+
+namespace
+{
+	enum
+	{
+		LITLEN_MAIN_BITS = 10,
+		DIST_MAIN_BITS = 8,
+		CODELEN_MAIN_BITS = 7,
+
+		// main table plus the worst case of one full subtable per long code
+		LITLEN_TABLE_SIZE = (1 << LITLEN_MAIN_BITS) + 288 * (1 << (15 - LITLEN_MAIN_BITS)),
+		DIST_TABLE_SIZE = (1 << DIST_MAIN_BITS) + 32 * (1 << (15 - DIST_MAIN_BITS)),
+		CODELEN_TABLE_SIZE = (1 << CODELEN_MAIN_BITS)
+	};
+
+	enum EntryKind
+	{
+		ENTRY_INVALID = 0, // no code maps here (incomplete code)
+		ENTRY_LITERAL,     // value is the literal byte (or the code length symbol)
+		ENTRY_BASE,        // value is a length or distance base, followed by 'extra' extra bits
+		ENTRY_END,         // end of block
+		ENTRY_SUBTABLE     // value is the start of a subtable indexed by 'extra' more bits
+	};
+
+	struct SHuffmanEntry
+	{
+		U16 value;
+		U8 bits;  // bits consumed by this entry
+		U8 info;  // EntryKind in the low 3 bits, extra bits above
+	};
+
+	struct SSymbol
+	{
+		U16 value;
+		U8 kind;
+		U8 extra;
+	};
+
+	inline U8 entryKind(const SHuffmanEntry& e) { return e.info & 7; }
+	inline U8 entryExtra(const SHuffmanEntry& e) { return e.info >> 3; }
+
+	const U16 LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+	const U8 LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+	const U16 DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+	const U8 DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+	const U8 CODELEN_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+	//! symbol meaning of the literal/length alphabet
+	struct SLitLenSymbols
+	{
+		SSymbol symbols[288];
+
+		SLitLenSymbols()
+		{
+			for (int i = 0; i < 288; ++i)
+			{
+				SSymbol& s = symbols[i];
+				s.value = (U16)i;
+				s.extra = 0;
+
+				if (i < 256)
+					s.kind = ENTRY_LITERAL;
+				else if (i == 256)
+					s.kind = ENTRY_END;
+				else if (i < 286)
+				{
+					s.kind = ENTRY_BASE;
+					s.value = LENGTH_BASE[i - 257];
+					s.extra = LENGTH_EXTRA[i - 257];
+				}
+				else
+					s.kind = ENTRY_INVALID;
+			}
+		}
+	};
+
+	//! symbol meaning of the distance alphabet
+	struct SDistSymbols
+	{
+		SSymbol symbols[32];
+
+		SDistSymbols()
+		{
+			for (int i = 0; i < 32; ++i)
+			{
+				SSymbol& s = symbols[i];
+				s.kind = (i < 30 ? ENTRY_BASE : ENTRY_INVALID);
+				s.value = (i < 30 ? DIST_BASE[i] : 0);
+				s.extra = (i < 30 ? DIST_EXTRA[i] : 0);
+			}
+		}
+	};
+
+	//! symbol meaning of the code length alphabet
+	struct SCodeLenSymbols
+	{
+		SSymbol symbols[19];
+
+		SCodeLenSymbols()
+		{
+			for (int i = 0; i < 19; ++i)
+			{
+				symbols[i].value = (U16)i;
+				symbols[i].kind = ENTRY_LITERAL;
+				symbols[i].extra = 0;
+			}
+		}
+	};
+
+	const SLitLenSymbols LITLEN_SYMBOLS;
+	const SDistSymbols DIST_SYMBOLS;
+	const SCodeLenSymbols CODELEN_SYMBOLS;
+
+	//! builds the decoding table of a canonical Huffman code
+	/** Like zlib, an incomplete literal/length or distance code is only accepted if it has a single
+	one bit code (or none), its unused slots stay ENTRY_INVALID so decoding them fails; an incomplete
+	code length code is always rejected (unless it has no codes at all).
+	\return False if the code lengths are over-subscribed or incomplete. */
+	bool buildTable(SHuffmanEntry* table, int tableSize, int mainBits, const U8* lengths, int count, const SSymbol* symbols, bool codeLengthCode = false)
+	{
+		int lengthCount[16] = {0};
+
+		for (int i = 0; i < count; ++i)
+			lengthCount[lengths[i]]++;
+
+		lengthCount[0] = 0;
+
+		int left = 1;
+		int maxLength = 0;
+		for (int len = 1; len <= 15; ++len)
+		{
+			left = (left << 1) - lengthCount[len];
+			if (left < 0)
+				return false;
+
+			if (lengthCount[len])
+				maxLength = len;
+		}
+
+		if (left > 0 && maxLength > 0 && (codeLengthCode || maxLength > 1))
+			return false;
+
+		int nextCode[16];
+		int code = 0;
+		for (int len = 1; len <= 15; ++len)
+		{
+			code = (code + lengthCount[len - 1]) << 1;
+			nextCode[len] = code;
+		}
+
+		int mainSize = 1 << mainBits;
+		int mainMask = mainSize - 1;
+		U16 codes[288];
+		U8 subBits[1 << LITLEN_MAIN_BITS] = {0};
+
+		memset(table, 0, mainSize * sizeof(SHuffmanEntry));
+
+		// assign the codes (bit reversed, as the stream is read from the least significant bit)
+		// and find the size of the subtable needed under each main table slot
+		for (int sym = 0; sym < count; ++sym)
+		{
+			int len = lengths[sym];
+			if (!len)
+				continue;
+
+			int c = nextCode[len]++;
+			int reversed = 0;
+			for (int i = 0; i < len; ++i, c >>= 1)
+				reversed = (reversed << 1) | (c & 1);
+
+			codes[sym] = (U16)reversed;
+
+			if (len > mainBits && len - mainBits > subBits[reversed & mainMask])
+				subBits[reversed & mainMask] = (U8)(len - mainBits);
+		}
+
+		int next = mainSize;
+		for (int i = 0; i < mainSize; ++i)
+		{
+			if (!subBits[i])
+				continue;
+
+			int subSize = 1 << subBits[i];
+			if (next + subSize > tableSize)
+				return false;
+
+			table[i].value = (U16)next;
+			table[i].bits = (U8)mainBits;
+			table[i].info = (U8)(ENTRY_SUBTABLE | (subBits[i] << 3));
+			memset(table + next, 0, subSize * sizeof(SHuffmanEntry));
+			next += subSize;
+		}
+
+		for (int sym = 0; sym < count; ++sym)
+		{
+			int len = lengths[sym];
+			if (!len)
+				continue;
+
+			SHuffmanEntry entry;
+			entry.value = symbols[sym].value;
+			entry.info = (U8)(symbols[sym].kind | (symbols[sym].extra << 3));
+
+			if (len <= mainBits)
+			{
+				entry.bits = (U8)len;
+				for (int i = codes[sym]; i < mainSize; i += 1 << len)
+					table[i] = entry;
+			}
+			else
+			{
+				const SHuffmanEntry& sub = table[codes[sym] & mainMask];
+				entry.bits = (U8)(len - mainBits);
+				for (int i = codes[sym] >> mainBits; i < (1 << entryExtra(sub)); i += 1 << entry.bits)
+					table[sub.value + i] = entry;
+			}
+		}
+
+		return true;
+	}
+
+	struct SFixedTables
+	{
+		SHuffmanEntry litLen[LITLEN_TABLE_SIZE];
+		SHuffmanEntry dist[DIST_TABLE_SIZE];
+
+		SFixedTables()
+		{
+			U8 lengths[288];
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			buildTable(litLen, LITLEN_TABLE_SIZE, LITLEN_MAIN_BITS, lengths, 288, LITLEN_SYMBOLS.symbols);
+
+			memset(lengths, 5, 32);
+			buildTable(dist, DIST_TABLE_SIZE, DIST_MAIN_BITS, lengths, 32, DIST_SYMBOLS.symbols);
+		}
+	};
+
+	const SFixedTables& fixedTables()
+	{
+		static const SFixedTables tables;
+		return tables;
+	}
+
+	inline uint64 loadLittleEndian64(const U8* p)
+	{
+		uint64 v;
+		memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		v = __builtin_bswap64(v);
+#endif
+		return v;
+	}
+
+	//! state of the bit reader
+	/** The input pointer may run past the end of the stream, the missing bytes read as zero;
+	the stream is only truncated if the bits are actually consumed (see isOverrun()). */
+	struct SBitReader
+	{
+		const U8* in;
+		const U8* inEnd;
+		uint64 bitBuffer;
+		int bitCount;
+
+		//! makes sure at least 56 bits are buffered
+		inline void refill()
+		{
+			if (inEnd - in >= 8)
+			{
+				bitBuffer |= loadLittleEndian64(in) << bitCount;
+				in += (63 - bitCount) >> 3;
+				bitCount |= 56;
+			}
+			else
+			{
+				while (bitCount <= 56)
+				{
+					if (in < inEnd)
+						bitBuffer |= (uint64)*in << bitCount;
+					++in;
+					bitCount += 8;
+				}
+			}
+		}
+
+		inline U32 peek(int count) const
+		{
+			return (U32)(bitBuffer & ((1ull << count) - 1));
+		}
+
+		inline void consume(int count)
+		{
+			bitBuffer >>= count;
+			bitCount -= count;
+		}
+
+		inline U32 take(int count)
+		{
+			U32 v = peek(count);
+			consume(count);
+			return v;
+		}
+
+		//! true if more bits were consumed than the stream holds
+		inline bool isOverrun() const
+		{
+			return in > inEnd && in - inEnd > (bitCount >> 3);
+		}
+
+		//! drops the bits up to the next byte boundary and moves the buffered bytes back to the input
+		inline void alignToByte()
+		{
+			consume(bitCount & 7);
+			in -= bitCount >> 3;
+			bitBuffer = 0;
+			bitCount = 0;
+		}
+	};
+
+	inline SHuffmanEntry decodeSymbol(SBitReader& reader, const SHuffmanEntry* table, int mainBits)
+	{
+		SHuffmanEntry e = table[reader.peek(mainBits)];
+
+		if (entryKind(e) == ENTRY_SUBTABLE)
+		{
+			reader.consume(mainBits);
+			e = table[e.value + reader.peek(entryExtra(e))];
+		}
+
+		reader.consume(e.bits);
+		return e;
+	}
+
+	//! copies a match, the source may overlap the destination
+	inline void copyMatch(U8* out, U8* outEnd, U32 dist, U32 length)
+	{
+		const U8* src = out - dist;
+		U8* end = out + length;
+
+		// wide copies may write up to 15 bytes past the match, so they need room before the end of the output
+		if (outEnd - end >= 16)
+		{
+			if (dist >= 16)
+			{
+				do
+				{
+					memcpy(out, src, 16);
+					out += 16;
+					src += 16;
+				} while (out < end);
+				return;
+			}
+
+			if (dist >= 8)
+			{
+				do
+				{
+					memcpy(out, src, 8);
+					out += 8;
+					src += 8;
+				} while (out < end);
+				return;
+			}
+
+			if (dist == 1)
+			{
+				memset(out, *src, length);
+				return;
+			}
+
+			// short distance: the first bytes repeat with a period of dist, so after
+			// writing them one by one, any multiple of dist that is at least 8 can be copied wide
+			U32 period = dist * ((8 + dist - 1) / dist);
+			U8* patternEnd = out + period;
+
+			while (out < patternEnd)
+				*out++ = *src++;
+
+			src = out - period;
+			while (out < end)
+			{
+				memcpy(out, src, 8);
+				out += 8;
+				src += 8;
+			}
+			return;
+		}
+
+		while (out < end)
+			*out++ = *src++;
+	}
+
+	struct SDynamicTables
+	{
+		SHuffmanEntry litLen[LITLEN_TABLE_SIZE];
+		SHuffmanEntry dist[DIST_TABLE_SIZE];
+	};
+
+	//! reads the code lengths of a dynamic block and builds its tables
+	bool readDynamicTables(SBitReader& reader, SDynamicTables& tables)
+	{
+		reader.refill();
+		int litLenCount = reader.take(5) + 257;
+		int distCount = reader.take(5) + 1;
+		int codeLenCount = reader.take(4) + 4;
+
+		if (litLenCount > 286 || distCount > 30)
+			return false;
+
+		// up to 19 lengths of 3 bits are more than a refill guarantees, so the buffer is refilled every 8 of them
+		U8 codeLenLengths[19] = {0};
+		for (int i = 0; i < codeLenCount; ++i)
+		{
+			if ((i & 7) == 0)
+				reader.refill();
+
+			codeLenLengths[CODELEN_ORDER[i]] = (U8)reader.take(3);
+		}
+
+		SHuffmanEntry codeLenTable[CODELEN_TABLE_SIZE];
+		if (!buildTable(codeLenTable, CODELEN_TABLE_SIZE, CODELEN_MAIN_BITS, codeLenLengths, 19, CODELEN_SYMBOLS.symbols, true))
+			return false;
+
+		U8 lengths[286 + 32];
+		int count = litLenCount + distCount;
+
+		for (int i = 0; i < count;)
+		{
+			reader.refill();
+			SHuffmanEntry e = decodeSymbol(reader, codeLenTable, CODELEN_MAIN_BITS);
+
+			if (entryKind(e) != ENTRY_LITERAL)
+				return false;
+
+			int repeat;
+			U8 value = 0;
+
+			if (e.value < 16)
+			{
+				lengths[i++] = (U8)e.value;
+				continue;
+			}
+			else if (e.value == 16)
+			{
+				if (i == 0)
+					return false;
+
+				value = lengths[i - 1];
+				repeat = 3 + reader.take(2);
+			}
+			else if (e.value == 17)
+				repeat = 3 + reader.take(3);
+			else
+				repeat = 11 + reader.take(7);
+
+			if (i + repeat > count)
+				return false;
+
+			memset(lengths + i, value, repeat);
+			i += repeat;
+		}
+
+		// the end of block code must exist
+		if (!lengths[256])
+			return false;
+
+		return buildTable(tables.litLen, LITLEN_TABLE_SIZE, LITLEN_MAIN_BITS, lengths, litLenCount, LITLEN_SYMBOLS.symbols)
+			&& buildTable(tables.dist, DIST_TABLE_SIZE, DIST_MAIN_BITS, lengths + litLenCount, distCount, DIST_SYMBOLS.symbols);
+	}
+}
+
+bool inflateBufferFast(void* out, U32 outSize, const void* in, U32 inSize)
+{
+	U8* outStart = (U8*)out;
+	U8* outPos = outStart;
+	U8* outEnd = outStart + outSize;
+
+	SBitReader reader;
+	reader.in = (const U8*)in;
+	reader.inEnd = reader.in + inSize;
+	reader.bitBuffer = 0;
+	reader.bitCount = 0;
+
+	SDynamicTables* dynamicTables = 0;
+	bool valid = true;
+	bool finalBlock;
+
+	do
+	{
+		reader.refill();
+		finalBlock = (reader.take(1) != 0);
+		U32 type = reader.take(2);
+
+		if (type == 0)
+		{
+			// stored block
+			reader.alignToByte();
+
+			if (reader.inEnd - reader.in < 4)
+			{
+				valid = false;
+				break;
+			}
+
+			U32 length = reader.in[0] | (reader.in[1] << 8);
+			U32 lengthComplement = reader.in[2] | (reader.in[3] << 8);
+			reader.in += 4;
+
+			if (length != (~lengthComplement & 0xffff) || (U32)(reader.inEnd - reader.in) < length || (U32)(outEnd - outPos) < length)
+			{
+				valid = false;
+				break;
+			}
+
+			memcpy(outPos, reader.in, length);
+			reader.in += length;
+			outPos += length;
+			continue;
+		}
+
+		const SHuffmanEntry* litLenTable;
+		const SHuffmanEntry* distTable;
+
+		if (type == 1)
+		{
+			litLenTable = fixedTables().litLen;
+			distTable = fixedTables().dist;
+		}
+		else if (type == 2)
+		{
+			if (!dynamicTables)
+				dynamicTables = new SDynamicTables;
+
+			if (!readDynamicTables(reader, *dynamicTables))
+			{
+				valid = false;
+				break;
+			}
+
+			litLenTable = dynamicTables->litLen;
+			distTable = dynamicTables->dist;
+		}
+		else
+		{
+			valid = false;
+			break;
+		}
+
+		for (;;)
+		{
+			// 56 bits cover the longest length code with its extra bits and distance code with its extra bits
+			reader.refill();
+			SHuffmanEntry e = decodeSymbol(reader, litLenTable, LITLEN_MAIN_BITS);
+			U8 kind = entryKind(e);
+
+			if (kind == ENTRY_LITERAL)
+			{
+				if (outPos == outEnd)
+				{
+					valid = false;
+					break;
+				}
+
+				*outPos++ = (U8)e.value;
+
+				// the bits left after the refill hold two more literals of the main table
+				for (int i = 0; i < 2; ++i)
+				{
+					e = litLenTable[reader.peek(LITLEN_MAIN_BITS)];
+					if (entryKind(e) != ENTRY_LITERAL || outPos == outEnd)
+						break;
+
+					reader.consume(e.bits);
+					*outPos++ = (U8)e.value;
+				}
+				continue;
+			}
+
+			if (kind == ENTRY_END)
+				break;
+
+			if (kind != ENTRY_BASE)
+			{
+				valid = false;
+				break;
+			}
+
+			U32 length = e.value + reader.take(entryExtra(e));
+
+			e = decodeSymbol(reader, distTable, DIST_MAIN_BITS);
+			if (entryKind(e) != ENTRY_BASE)
+			{
+				valid = false;
+				break;
+			}
+
+			U32 dist = e.value + reader.take(entryExtra(e));
+
+			if (dist > (U32)(outPos - outStart) || length > (U32)(outEnd - outPos))
+			{
+				valid = false;
+				break;
+			}
+
+			copyMatch(outPos, outEnd, dist, length);
+			outPos += length;
+		}
+
+		if (reader.isOverrun())
+			valid = false;
+
+	} while (valid && !finalBlock);
+
+	delete dynamicTables;
+
+	return valid && outPos == outEnd && !reader.isOverrun();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef __INFLATE_BACKEND_H_INCLUDED__
+#define __INFLATE_BACKEND_H_INCLUDED__
+
+#include "TypeDef.h"
+
+/*!
+	Whole-buffer decoders for the raw deflate streams of pack and zip entries.
+	When the uncompressed size of an entry is known, the entry can be decoded in one call
+	straight into its final buffer, which is much faster than driving zlib's streaming inflate().
+*/
+
+//! decodes a complete raw deflate stream into a buffer of known size
+/** \param out Output buffer.
+\param outSize Size of the uncompressed data, the stream must produce exactly this many bytes.
+\param in Compressed stream.
+\param inSize Size of the compressed stream.
+\return True if the stream was valid and produced exactly outSize bytes. */
+typedef bool (*InflateBufferFunc)(void* out, U32 outSize, const void* in, U32 inSize);
+
+//! decodes with zlib's inflate()
+bool inflateBufferZlib(void* out, U32 outSize, const void* in, U32 inSize);
+
+//! decodes with a table driven decoder that refills a 64-bit bit buffer with single unaligned loads
+//! and copies matches with wide overlapping stores
+bool inflateBufferFast(void* out, U32 outSize, const void* in, U32 inSize);
+
+//! selects the decoder used by inflateBuffer(), 0 selects the default (inflateBufferFast)
+/** Not synchronized: select the backend before entries are opened from other threads. */
+void setInflateBackend(InflateBufferFunc backend);
+
+//! returns the decoder used by inflateBuffer()
+InflateBufferFunc getInflateBackend();
+
+//! decodes with the selected backend, streams it rejects are decoded again with zlib
+bool inflateBuffer(void* out, U32 outSize, const void* in, U32 inSize);
+
+#endif
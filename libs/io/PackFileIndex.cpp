@@ -0,0 +1,93 @@
+#include <string.h>
+#include "PackFileIndex.h"
+
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#endif
+
+U32 CPackFileIndex::hashFileName(const char* filename)
+{
+	if (filename[0] == '.' && filename[1] == '/')
+		filename += 2;
+
+	// same as hashStringSimple() over the lower case name
+	U32 hash = 0;
+	for (; *filename; ++filename)
+	{
+		char c = *filename;
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+
+		hash = hash * 13 + (signed char)c;
+	}
+
+	return hash;
+}
+
+void CPackFileIndex::build(const std::vector<SPackResFileEntry>& entries)
+{
+	U32 size = 16;
+	while (size < entries.size() * 2)
+		size <<= 1;
+
+	SSlot empty = {0, -1};
+	Slots.assign(size, empty);
+	Mask = size - 1;
+
+	for (int32 i = 0; i < (int32)entries.size(); ++i)
+	{
+		const SPackResFileEntry& entry = entries[i];
+		U32 slot = firstSlot(entry.filePathHash);
+
+		while (Slots[slot].index != -1)
+		{
+			const SPackResFileEntry& other = entries[Slots[slot].index];
+
+			if (Slots[slot].hash == entry.filePathHash && !strcasecmp(other.fileName, entry.fileName))
+				break;
+
+			slot = (slot + 1) & Mask;
+		}
+
+		if (Slots[slot].index == -1 || layer(entry) > layer(entries[Slots[slot].index]))
+		{
+			Slots[slot].hash = entry.filePathHash;
+			Slots[slot].index = i;
+		}
+	}
+}
+
+void CPackFileIndex::clear()
+{
+	Slots.clear();
+	Mask = 0;
+}
+
+int32 CPackFileIndex::find(const std::vector<SPackResFileEntry>& entries, const char* filename) const
+{
+	if (Slots.empty())
+		return -1;
+
+	U32 hash = hashFileName(filename);
+
+	if (filename[0] == '.' && filename[1] == '/')
+		filename += 2;
+
+	for (U32 slot = firstSlot(hash); Slots[slot].index != -1; slot = (slot + 1) & Mask)
+	{
+		if (Slots[slot].hash == hash && !strcasecmp(entries[Slots[slot].index].fileName, filename))
+			return Slots[slot].index;
+	}
+
+	return -1;
+}
+
+bool CPackFileIndex::assign(const SSlot* slots, U32 slotCount)
+{
+	if (slotCount == 0 || (slotCount & (slotCount - 1)))
+		return false;
+
+	Slots.assign(slots, slots + slotCount);
+	Mask = slotCount - 1;
+	return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef __PACK_FILE_INDEX_H_INCLUDED__
+#define __PACK_FILE_INDEX_H_INCLUDED__
+
+#include "CPackResReader.h"
+
+/*!
+	Open addressing hash index over the entries of a pack (and of the patches merged into it).
+	Each slot keeps the path hash next to the entry index, so a lookup compares hashes without
+	touching the entry list and verifies the name of the matching entry only.
+	The index is kept at most half full, so a lookup usually is a single probe.
+*/
+class CPackFileIndex
+{
+public:
+	CPackFileIndex()
+		: Mask(0)
+	{
+	}
+
+	//! builds the index over the entries
+	/** If a name occurs more than once (merging a patch can append its entry instead of
+	redirecting the existing one), the entry of the latest patch is indexed, then the entry of
+	an earlier patch, then the entry of the main pack. */
+	void build(const std::vector<SPackResFileEntry>& entries);
+
+	//! removes all entries
+	void clear();
+
+	//! returns the index of the entry with this name, or -1
+	/** The name is normalized the same way as in CPackResReader::findFile():
+	a leading "./" is ignored and the comparison is case insensitive.
+	\param entries The entries the index was built over. */
+	int32 find(const std::vector<SPackResFileEntry>& entries, const char* filename) const;
+
+	//! returns the path hash of a file name, as stored in SPackResFileEntry::filePathHash
+	static U32 hashFileName(const char* filename);
+
+	struct SSlot
+	{
+		U32 hash;
+		int32 index; // -1 for an empty slot
+	};
+
+	//! returns the slots, to store the index (see CPackIndexFile)
+	const std::vector<SSlot>& getSlots() const
+	{
+		return Slots;
+	}
+
+	//! replaces the index by stored slots
+	/** \param slots Slots returned by getSlots() of an index built over the same entries.
+	\param slotCount Number of slots, must be a power of two.
+	\return False if slotCount is not a power of two. */
+	bool assign(const SSlot* slots, U32 slotCount);
+
+private:
+	//! returns the precedence of an entry, entries redirected to a later patch come first
+	static int32 layer(const SPackResFileEntry& entry)
+	{
+		return entry.fileDataPosition < 0 ? 1 + ((entry.fileDataPosition >> 16) & 0x7fff) : 0;
+	}
+
+	//! returns the first slot to probe for a hash
+	U32 firstSlot(U32 hash) const
+	{
+		// the path hash is weak in its low bits, so mix it before masking
+		return (hash * 0x9E3779B1u) >> 7 & Mask;
+	}
+
+	std::vector<SSlot> Slots;
+	U32 Mask;
+};
+
+#endif
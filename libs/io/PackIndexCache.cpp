@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <sys/stat.h>
+#include "PackIndexCache.h"
+
+#ifdef _WIN32
+#define stat _stat
+#endif
+
+// 'GPIX'
+#define PACK_INDEX_MAGIC 0x58495047
+#define PACK_INDEX_VERSION 2
+
+CPackIndexCache::CPackIndexCache()
+	: File(0), Header(0), Entries(0), Slots(0), Names(0)
+{
+}
+
+CPackIndexCache::~CPackIndexCache()
+{
+	if (File)
+		File->drop();
+}
+
+bool CPackIndexCache::getPackStamp(const char* packFileName, int64* size, int64* time)
+{
+	struct stat status;
+
+	if (!packFileName || stat(packFileName, &status) != 0)
+		return false;
+
+	// the time is compared in nanoseconds where the system keeps them, so that a pack rewritten
+	// with the same size within the same second does not match its old index
+	*size = status.st_size;
+#if defined(_WIN32)
+	*time = (int64)status.st_mtime * 1000000000;
+#elif defined(__APPLE__)
+	*time = (int64)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+	*time = (int64)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
+bool CPackIndexCache::load(const char* indexFileName, const char* packFileName)
+{
+	int64 packSize, packTime;
+
+	if (!indexFileName || !getPackStamp(packFileName, &packSize, &packTime))
+		return false;
+
+	IReadResFile* file = createMappedReadFile(indexFileName);
+	if (!file)
+		return false;
+
+	long size;
+	const char* data = (const char*)file->getBuffer(&size);
+	const SHeader* header = (const SHeader*)data;
+
+	if (!data || size < (long)sizeof(SHeader)
+		|| header->Magic != PACK_INDEX_MAGIC || header->Version != PACK_INDEX_VERSION
+		|| header->PackSize != packSize || header->PackTime != packTime
+		// the index needs an empty slot to end the probing
+		|| header->SlotCount <= header->EntryCount || header->NamesSize == 0
+		|| (uint64)size != sizeof(SHeader) + (uint64)header->EntryCount * sizeof(SEntry)
+			+ (uint64)header->SlotCount * sizeof(CPackFileIndex::SSlot) + header->NamesSize)
+	{
+		file->drop();
+		return false;
+	}
+
+	const SEntry* entries = (const SEntry*)(data + sizeof(SHeader));
+	const CPackFileIndex::SSlot* slots = (const CPackFileIndex::SSlot*)(entries + header->EntryCount);
+	const char* names = (const char*)(slots + header->SlotCount);
+	bool valid = (names[header->NamesSize - 1] == 0);
+
+	for (U32 i = 0; valid && i < header->EntryCount; ++i)
+		valid = (entries[i].nameOffset < header->NamesSize);
+
+	for (U32 i = 0; valid && i < header->SlotCount; ++i)
+		valid = (slots[i].index >= -1 && slots[i].index < (int32)header->EntryCount);
+
+	if (!valid)
+	{
+		file->drop();
+		return false;
+	}
+
+	if (File)
+		File->drop();
+
+	File = file;
+	Header = header;
+	Entries = entries;
+	Slots = slots;
+	Names = names;
+	return true;
+}
+
+void CPackIndexCache::getEntries(std::vector<SPackResFileEntry>& entries) const
+{
+	if (!Header)
+		return;
+
+	entries.resize(Header->EntryCount);
+
+	for (U32 i = 0; i < Header->EntryCount; ++i)
+	{
+		const SEntry& stored = Entries[i];
+		SPackResFileEntry& entry = entries[i];
+
+		entry.filePathHash = stored.filePathHash;
+		entry.fileDataPosition = stored.fileDataPosition;
+		entry.fileName = Names + stored.nameOffset;
+		entry.localheaderSize = stored.localheaderSize;
+		entry.compressionMethod = stored.compressionMethod;
+		entry.uncompressedSize = stored.uncompressedSize;
+		entry.compressedSize = stored.compressedSize;
+	}
+}
+
+bool CPackIndexCache::getIndex(CPackFileIndex& index) const
+{
+	return Header && index.assign(Slots, Header->SlotCount);
+}
+
+bool CPackIndexCache::write(const char* indexFileName, const char* packFileName, const std::vector<SPackResFileEntry>& entries, const CPackFileIndex& index)
+{
+	SHeader header;
+	memset(&header, 0, sizeof(header));
+
+	if (!indexFileName || !getPackStamp(packFileName, &header.PackSize, &header.PackTime))
+		return false;
+
+	const std::vector<CPackFileIndex::SSlot>& slots = index.getSlots();
+	std::vector<SEntry> storedEntries(entries.size());
+	std::string names;
+
+	for (U32 i = 0; i < entries.size(); ++i)
+	{
+		const SPackResFileEntry& entry = entries[i];
+		SEntry& stored = storedEntries[i];
+
+		stored.filePathHash = entry.filePathHash;
+		stored.fileDataPosition = entry.fileDataPosition;
+		stored.nameOffset = (U32)names.size();
+		stored.localheaderSize = entry.localheaderSize;
+		stored.compressionMethod = entry.compressionMethod;
+		stored.uncompressedSize = entry.uncompressedSize;
+		stored.compressedSize = entry.compressedSize;
+
+		names.append(entry.fileName ? entry.fileName : "");
+		names.push_back(0);
+	}
+
+	// an empty pack still gets a terminated (empty) name block
+	if (names.empty())
+		names.push_back(0);
+
+	header.Magic = PACK_INDEX_MAGIC;
+	header.Version = PACK_INDEX_VERSION;
+	header.EntryCount = (U32)storedEntries.size();
+	header.SlotCount = (U32)slots.size();
+	header.NamesSize = (U32)names.size();
+
+	std::string tempFileName = std::string(indexFileName) + ".tmp";
+	FILE* file = fopen(tempFileName.c_str(), "wb");
+
+	if (!file)
+		return false;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& (storedEntries.empty() || fwrite(&storedEntries[0], sizeof(SEntry), storedEntries.size(), file) == storedEntries.size())
+		&& (slots.empty() || fwrite(&slots[0], sizeof(CPackFileIndex::SSlot), slots.size(), file) == slots.size())
+		&& fwrite(names.data(), 1, names.size(), file) == names.size();
+
+	if (fclose(file) != 0)
+		written = false;
+
+#ifdef _WIN32
+	// rename() does not replace an existing file on Windows
+	if (written)
+		remove(indexFileName);
+#endif
+
+	if (!written || rename(tempFileName.c_str(), indexFileName) != 0)
+	{
+		remove(tempFileName.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef __PACK_INDEX_CACHE_H_INCLUDED__
+#define __PACK_INDEX_CACHE_H_INCLUDED__
+
+#include "PackFileIndex.h"
+
+/*!
+	Index file stored next to a pack, so that the pack can be opened without scanning it.
+	It holds the sorted file list, the hash index and all names, laid out so that the
+	file is used in place once it is mapped: loading is a map and a copy of the entry array.
+	The size and modification time (in nanoseconds) of the pack are stored in the index file,
+	an index file that does not match its pack any more is ignored (and replaced by the reader).
+
+	Layout (native byte order): SHeader, SEntry[EntryCount], CPackFileIndex::SSlot[SlotCount],
+	NamesSize bytes of zero terminated names.
+*/
+class CPackIndexCache
+{
+public:
+	CPackIndexCache();
+
+	~CPackIndexCache();
+
+	//! maps an index file and checks it against its pack
+	/** \return False if the index file is missing, does not match the pack or is damaged. */
+	bool load(const char* indexFileName, const char* packFileName);
+
+	//! fills the file list of a pack from the loaded index, in the order the pack reader keeps it
+	/** The names point into the mapped index file, see getFile(). */
+	void getEntries(std::vector<SPackResFileEntry>& entries) const;
+
+	//! fills the hash index from the loaded index
+	bool getIndex(CPackFileIndex& index) const;
+
+	//! returns the mapped index file, it must be kept (grabbed) as long as the names are used
+	IReadResFile* getFile() const
+	{
+		return File;
+	}
+
+	//! writes the index file of a pack
+	/** The file is written under a temporary name and renamed, so readers never see a partial index.
+	\param entries File list of the pack, as built by the pack reader.
+	\param index Hash index built over entries. */
+	static bool write(const char* indexFileName, const char* packFileName, const std::vector<SPackResFileEntry>& entries, const CPackFileIndex& index);
+
+private:
+	struct SHeader
+	{
+		U32 Magic;
+		U32 Version;
+		int64 PackSize;
+		int64 PackTime;
+		U32 EntryCount;
+		U32 SlotCount;
+		U32 NamesSize;
+		U32 Reserved;
+	};
+
+	struct SEntry
+	{
+		U32 filePathHash;
+		int32 fileDataPosition;
+		U32 nameOffset;
+		int16 localheaderSize;
+		int16 compressionMethod;
+		U32 uncompressedSize;
+		U32 compressedSize;
+	};
+
+	//! returns size and modification time of a pack (nanoseconds since the epoch)
+	static bool getPackStamp(const char* packFileName, int64* size, int64* time);
+
+	IReadResFile* File;
+	const SHeader* Header;
+	const SEntry* Entries;
+	const CPackFileIndex::SSlot* Slots;
+	const char* Names;
+};
+
+#endif
@@ -21,6 +21,12 @@ public:
 
 	virtual ~CPackPatchReader();
 	virtual IReadResFile* openFile(const char* filename);
+	IReadResFile* openFileView(const char* filename);
+
+	//open an entry of the main FileList by index, entries replaced by a patch are opened from the patch
+	IReadResFile* openFile(int32 index);
+	IReadResFile* openFileView(int32 index);
+
 	virtual bool addPackPatchFile(const char* filename, bool ignoreCase = true, bool ignorePaths = true);
 
 protected:
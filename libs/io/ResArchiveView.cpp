@@ -0,0 +1,285 @@
+#include "CMappedReadResFile.h"
+#include "InflateBackend.h"
+#include "PackPatchReader.h"
+
+// signature of the local file header in Gameloft packs ('GBMP'), zip local headers use 'PK\3\4'
+#define PACK_LOCAL_HEADER_SIG 0x504d4247
+#define ZIP_LOCAL_HEADER_SIG 0x04034b50
+
+//! reads the local header of a pack entry from an in-memory pack
+/** \param pack Pack bytes.
+\param packSize Size of the pack in bytes.
+\param headerPos Position of the local header (SPackResFileEntry::fileDataPosition).
+\param dataPos Receives the position of the entry data.
+\param header Receives the local header; if the sizes follow in a data descriptor, they are copied into it.
+\return False if there is no valid local header at headerPos. */
+static bool readPackLocalHeader(const char* pack, long packSize, long headerPos, long* dataPos, SZIPResFileHeader* header)
+{
+	if (headerPos < 0 || headerPos + (long)sizeof(SZIPResFileHeader) > packSize)
+		return false;
+
+	memcpy(header, pack + headerPos, sizeof(SZIPResFileHeader));
+
+	if (header->Sig != ZIP_LOCAL_HEADER_SIG && header->Sig != PACK_LOCAL_HEADER_SIG)
+		return false;
+
+	long pos = headerPos + sizeof(SZIPResFileHeader) + header->FilenameLength + header->ExtraFieldLength;
+
+	// the data descriptor is stored between the extra field and the data
+	if (header->GeneralBitFlag & ZIP_RES_INFO_IN_DATA_DESCRITOR)
+	{
+		if (pos + (long)sizeof(SZIPResFileDataDescriptor) > packSize)
+			return false;
+
+		memcpy(&header->DataDescriptor, pack + pos, sizeof(SZIPResFileDataDescriptor));
+		pos += sizeof(SZIPResFileDataDescriptor);
+	}
+
+	*dataPos = pos;
+	return true;
+}
+
+//! reads bytes at a position of an archive file
+/** Positional files are read without a lock; any other file is shared through its read
+position, so the lock is held from the seek until the end of the read.
+\param mutex Lock of the archive reader, 0 if the file is not shared.
+\return True if all bytes were read. */
+static bool readArchive(IReadResFile* file, pthread_mutex_t* mutex, long pos, void* buffer, U32 size)
+{
+	IPositionalReadResFile* positional = dynamic_cast<IPositionalReadResFile*>(file);
+
+	if (positional)
+		return positional->readAt(pos, buffer, size) == (S32)size;
+
+	if (mutex)
+		pthread_mutex_lock(mutex);
+	bool read = file->seek(pos) && file->read(buffer, size) == (S32)size;
+	if (mutex)
+		pthread_mutex_unlock(mutex);
+
+	return read;
+}
+
+//! copies a stored entry into a new memory file
+/** \return The memory file, or 0 if the entry could not be read. */
+static IReadResFile* openStoredFile(IReadResFile* file, pthread_mutex_t* mutex, long dataPos, const SZIPResFileDataDescriptor& sizes, const char* fileName)
+{
+	if (sizes.UncompressedSize < 0)
+		return 0;
+
+	char* buffer = new char[sizes.UncompressedSize ? sizes.UncompressedSize : 1];
+
+	if (!readArchive(file, mutex, dataPos, buffer, sizes.UncompressedSize))
+	{
+		delete[] buffer;
+		return 0;
+	}
+
+	return createMemoryReadFile(buffer, sizes.UncompressedSize, fileName, true);
+}
+
+//! decodes a deflated entry in one pass into a new memory file
+/** \param file Archive file; the compressed bytes are used in place if it is memory mapped.
+\param mutex Lock of the archive reader (see readArchive()), 0 if the file is not shared.
+\param dataPos Position of the compressed data.
+\param sizes Compressed and uncompressed size of the entry.
+\param fileName Name reported by the memory file.
+\return The memory file, or 0 if the entry could not be read or decoded. */
+static IReadResFile* openInflatedFile(IReadResFile* file, pthread_mutex_t* mutex, long dataPos, const SZIPResFileDataDescriptor& sizes, const char* fileName)
+{
+	if (sizes.CompressedSize < 0 || sizes.UncompressedSize < 0)
+		return 0;
+
+	CMappedReadResFile* mapped = dynamic_cast<CMappedReadResFile*>(file);
+	const char* compressed;
+	char* compressedBuffer = 0;
+
+	if (mapped)
+	{
+		long size;
+		compressed = (const char*)mapped->getBuffer(&size);
+
+		if (!compressed || dataPos < 0 || dataPos + sizes.CompressedSize > size)
+			return 0;
+
+		compressed += dataPos;
+	}
+	else
+	{
+		compressedBuffer = new char[sizes.CompressedSize];
+
+		if (!readArchive(file, mutex, dataPos, compressedBuffer, sizes.CompressedSize))
+		{
+			delete[] compressedBuffer;
+			return 0;
+		}
+
+		compressed = compressedBuffer;
+	}
+
+	char* buffer = new char[sizes.UncompressedSize ? sizes.UncompressedSize : 1];
+	bool valid = inflateBuffer(buffer, sizes.UncompressedSize, compressed, sizes.CompressedSize);
+
+	delete[] compressedBuffer;
+
+	if (!valid)
+	{
+		delete[] buffer;
+		return 0;
+	}
+
+	return createMemoryReadFile(buffer, sizes.UncompressedSize, fileName, true);
+}
+
+IReadResFile* CPackResReader::openFileView(const char* filename)
+{
+	int32 index = findFile(filename);
+
+	if (index == -1)
+		return 0;
+
+	return openFileView(index);
+}
+
+bool CPackResReader::readLocalHeader(int32 index, long* dataPos, SZIPResFileHeader* header)
+{
+	if (!m_file || index < 0 || index >= (int32)m_fileList.size())
+		return false;
+
+	long headerPos = m_fileList[index].fileDataPosition;
+	CMappedReadResFile* pack = dynamic_cast<CMappedReadResFile*>(m_file);
+
+	if (pack)
+	{
+		long packSize;
+		const char* packData = (const char*)pack->getBuffer(&packSize);
+		return packData && readPackLocalHeader(packData, packSize, headerPos, dataPos, header);
+	}
+
+	if (!readArchive(m_file, &mutex, headerPos, header, sizeof(SZIPResFileHeader))
+		|| (header->Sig != ZIP_LOCAL_HEADER_SIG && header->Sig != PACK_LOCAL_HEADER_SIG))
+		return false;
+
+	long pos = headerPos + sizeof(SZIPResFileHeader) + header->FilenameLength + header->ExtraFieldLength;
+
+	if (header->GeneralBitFlag & ZIP_RES_INFO_IN_DATA_DESCRITOR)
+	{
+		if (!readArchive(m_file, &mutex, pos, &header->DataDescriptor, sizeof(SZIPResFileDataDescriptor)))
+			return false;
+
+		pos += sizeof(SZIPResFileDataDescriptor);
+	}
+
+	*dataPos = pos;
+	return true;
+}
+
+void CPackResReader::attachFile(IReadResFile* file, bool scan)
+{
+	if (m_file || !file)
+		return;
+
+	m_file = file;
+	m_file->grab();
+
+	if (scan)
+	{
+		scanFileHeader();
+		std::sort(m_fileList.begin(), m_fileList.end());
+	}
+}
+
+IReadResFile* CPackResReader::openFileView(int32 index)
+{
+	CMappedReadResFile* pack = dynamic_cast<CMappedReadResFile*>(m_file);
+	SZIPResFileHeader header;
+	long dataPos;
+
+	if (!readLocalHeader(index, &dataPos, &header))
+		return openFile(index);
+
+	if (header.CompressionMethod == 8)
+		return openInflatedFile(m_file, &mutex, dataPos, header.DataDescriptor, m_fileList[index].fileName);
+
+	if (header.CompressionMethod != 0)
+		return openFile(index);
+
+	if (pack)
+		return pack->createView(dataPos, header.DataDescriptor.UncompressedSize, m_fileList[index].fileName);
+
+	if (dynamic_cast<IPositionalReadResFile*>(m_file))
+		return openStoredFile(m_file, &mutex, dataPos, header.DataDescriptor, m_fileList[index].fileName);
+
+	return openFile(index);
+}
+
+IReadResFile* CZipResReader::openFileView(const char* filename)
+{
+	int32 index = findFile(filename);
+
+	if (index == -1)
+		return 0;
+
+	return openFileView(index);
+}
+
+IReadResFile* CZipResReader::openFileView(int32 index)
+{
+	CMappedReadResFile* zip = dynamic_cast<CMappedReadResFile*>(File);
+
+	if (index < 0 || index >= (int32)FileList.size())
+		return 0;
+
+	const SZipResFileEntry& entry = FileList[index];
+
+	if (entry.header.CompressionMethod == 8)
+		return openInflatedFile(File, &mutex, entry.fileDataPosition, entry.header.DataDescriptor, entry.zipFileName.c_str());
+
+	if (entry.header.CompressionMethod != 0)
+		return openFile(index);
+
+	if (zip)
+		return zip->createView(entry.fileDataPosition, entry.header.DataDescriptor.UncompressedSize, entry.zipFileName.c_str());
+
+	if (dynamic_cast<IPositionalReadResFile*>(File))
+		return openStoredFile(File, &mutex, entry.fileDataPosition, entry.header.DataDescriptor, entry.zipFileName.c_str());
+
+	return openFile(index);
+}
+
+IReadResFile* CPackPatchReader::openFile(int32 index)
+{
+	if (index < 0 || index >= (int32)m_fileList.size())
+		return 0;
+
+	// entries replaced by a patch store the patch index and the index inside the patch
+	int32 position = m_fileList[index].fileDataPosition;
+
+	if (position < 0)
+		return PackPatchFiles[(position >> 16) & 0x7fff]->openFile(position & 0xffff);
+
+	return CPackResReader::openFile(index);
+}
+
+IReadResFile* CPackPatchReader::openFileView(const char* filename)
+{
+	int32 index = findFile(filename);
+
+	if (index == -1)
+		return 0;
+
+	return openFileView(index);
+}
+
+IReadResFile* CPackPatchReader::openFileView(int32 index)
+{
+	if (index < 0 || index >= (int32)m_fileList.size())
+		return 0;
+
+	int32 position = m_fileList[index].fileDataPosition;
+
+	if (position < 0)
+		return PackPatchFiles[(position >> 16) & 0x7fff]->openFileView(position & 0xffff);
+
+	return CPackResReader::openFileView(index);
+}
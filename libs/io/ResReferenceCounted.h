@@ -3,6 +3,10 @@
 #ifndef __RESIREFERENCECOUNTED_H__
 #define __RESIREFERENCECOUNTED_H__
 
+#include <atomic>
+
+static_assert(sizeof(std::atomic<unsigned int>) == sizeof(unsigned int), "the reference counter must keep the layout libio was built with");
+
 class IResReferenceCounted
 {
 protected:
@@ -17,9 +21,19 @@ protected:
 
 public:
 
+	//! grab() and drop() may be called from several threads for the same object.
+	/** Taking a reference needs no ordering (the caller already holds one); the final
+	drop() acquires the writes of all other owners before the object is deleted.
+	This holds only for code compiled from this header. libio_linux.a / libio_windows.a
+	are prebuilt with the plain counter: the readers of the library (CPackResReader,
+	CPackPatchReader, CZipResReader) grab and drop with non-atomic increments and
+	decrements, e.g. ~CPackResReader() drops its file with a plain decrement. Objects
+	created or released inside the library are therefore still racy until it is rebuilt
+	from this header, so a reader must not be shared between threads: create, use and
+	delete it on one thread, and don't let other threads drop its file meanwhile. */
 	void grab() const
 	{
-		++ReferenceCounter;
+		ReferenceCounter.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	bool drop() const
@@ -27,9 +41,7 @@ public:
 		// someone is doing bad reference counting.
 		//assert(ReferenceCounter <= 0);
 
-		--ReferenceCounter;
-
-		if (ReferenceCounter == 0)
+		if (ReferenceCounter.fetch_sub(1, std::memory_order_acq_rel) == 1)
 		{
 			const_cast<IResReferenceCounted*>(this)->onDelete();
 			delete this;
@@ -52,7 +64,8 @@ protected:
 	}
 
 protected:
-	mutable unsigned int ReferenceCounter;
+	// same size and alignment as the plain unsigned int it replaces (libio is prebuilt against that layout)
+	mutable std::atomic<unsigned int> ReferenceCounter;
 #ifdef _DEBUG
 	const char* DebugName;
 #endif
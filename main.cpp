@@ -2,6 +2,7 @@
 #include <iomanip>
 #include <string>
 #include <filesystem>
+#include <thread>
 #include "libs/glad/glad.h"                  // library for OpenGL functions loading (like glClear or glViewport)
 #include "libs/glm/glm.hpp"                  // library for OpenGL style mathematics (basic vector and matrix mathematics functions)
 #include "libs/glm/gtc/matrix_transform.hpp" // for matrix transformation functions
@@ -16,6 +17,8 @@
 #include "shader.h"              // implementation of the graphics pipeline
 #include "camera.h"              // implementation of the camera system
 #include "light.h"               // definition of the light settings and light cube
+#include "bounds.h"              // bounding volumes and view frustum culling
+#include "profiler.h"            // CPU / GPU frame profiler
 
 #ifdef __linux__
 #include <GLFW/glfw3.h> // library for creating windows and handling input – mouse clicks, keyboard input, or window resizes
@@ -25,6 +28,12 @@
 
 #include "libs/io/PackPatchReader.h"
 #include "resFile.h"
+#include "fileCache.h"
+#include "modelView.h"
+#include "vertexFormat.h"
+#include "textureNames.h"
+#include "meshOptimize.h"
+#include "meshSimplify.h"
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
@@ -32,6 +41,7 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow *window);
 void loadBDAEModel(const char *fpath);
+void drawIndexList(int index);
 
 // window settings
 bool isFullscreen = false;
@@ -66,6 +76,28 @@ std::vector<unsigned int> EBOs;
 std::vector<float> vertices;
 std::vector<std::vector<unsigned short>> indices;
 std::vector<unsigned int> textures;
+float weldEpsilon = 0.0f; // tolerance for merging the vertices of the loaded meshes (0: only bit-identical vertices are merged)
+
+// level of detail: indices (and EBOs) hold the submeshes of each level one after another, the level drawn is the coarsest one whose error projects to less than LOD_PIXEL_ERROR pixels
+#define LOD_PIXEL_ERROR 1.0f
+float lodErrors[LOD_COUNT]; // largest error among the meshes at each level (model units)
+int currentLOD;
+
+// bounds of the submeshes (of the full resolution level, which contain the other levels) and of the model; submeshes outside of the view frustum are not drawn
+std::vector<BoundingVolume> submeshBounds;
+BoundingVolume modelBounds;
+int culledSubmeshCount;
+
+// how each index list (and its EBO) is drawn: the indices are converted to indices into the whole vertex buffer on upload, stored in 16 bits when its largest index fits, in 32 bits otherwise
+struct DrawRange
+{
+    GLenum IndexType;
+    int IndexCount;
+};
+
+std::vector<DrawRange> drawRanges;
+
+Profiler profiler; // times of the parts of each frame, shown in the profiler panel
 
 int main()
 {
@@ -97,6 +129,7 @@ int main()
 
     // load all OpenGL function pointers
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    profiler.init();
 
     // setup settings panel (Dear ImGui library)
     ImGui::CreateContext();
@@ -160,17 +193,24 @@ int main()
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        profiler.beginFrame();
+
         // handle keyboard input
+        profiler.beginScope(SCOPE_INPUT);
+
         if (!fileDialogOpen)
             processInput(window);
 
+        profiler.endScope(SCOPE_INPUT);
+
         // prepare ImGui for a new frame
+        profiler.beginScope(SCOPE_UI);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
         // define settings panel with fixed size and position
-        ImGui::SetNextWindowSize(ImVec2(200.0f, 270.0f), ImGuiCond_None);
+        ImGui::SetNextWindowSize(ImVec2(200.0f, 310.0f), ImGuiCond_None);
         ImGui::SetNextWindowPos(ImVec2(20.0f, 20.0f), ImGuiCond_None);
 
         settingsPanelHovered = ImGui::GetIO().WantCaptureMouse;
@@ -218,6 +258,8 @@ int main()
             ImGui::Text("Size: %d Bytes", fileSize);
             ImGui::Text("Vertices: %d", vertexCount);
             ImGui::Text("Faces: %d", faceCount);
+            ImGui::Text("Level of detail: %d", currentLOD);
+            ImGui::Text("Culled submeshes: %d", culledSubmeshCount);
             ImGui::NewLine();
             ImGui::Checkbox("Base Mesh On/Off", &displayBaseMesh);
             ImGui::Spacing();
@@ -232,13 +274,23 @@ int main()
 
         ImGui::End();
 
+        profiler.drawPanel(20.0f, 350.0f);
+        profiler.endScope(SCOPE_UI);
+
+        profiler.beginGPUScope(GPU_SCENE);
+        profiler.beginScope(SCOPE_UNIFORMS);
+
         glClearColor(0.85f, 0.85f, 0.85f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // clear the color buffer (fill the screen with a clear color) and the depth buffer; otherwise the information of the previous frame stays in these buffers
 
         // update dynamic shader uniforms on GPU
         glm::mat4 model = glm::mat4(1.0f);
         glm::mat4 view = ourCamera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(ourCamera.Zoom), (float)currentScreenWidth / (float)currentScreenHeight, 0.1f, 1000.0f);
+
+        // clip planes that enclose the bounds of the model from wherever the camera is (a large model is framed far away), but never a smaller range than the default 0.1 – 1000; the near plane follows the far one to keep the depth precision
+        float farPlane = std::max(glm::length(ourCamera.Position - modelBounds.Center) + 2.0f * modelBounds.Radius, 1000.0f);
+        float nearPlane = std::max(farPlane / 10000.0f, 0.01f);
+        glm::mat4 projection = glm::perspective(glm::radians(ourCamera.Zoom), (float)currentScreenWidth / (float)currentScreenHeight, nearPlane, farPlane);
 
         ourShader.use();
         ourShader.setMat4("model", model);
@@ -247,7 +299,31 @@ int main()
         ourShader.setBool("lighting", showLighting);
         ourShader.setVec3("cameraPos", ourCamera.Position);
 
+        // select the level of detail by the size of its error on the screen (the distance is measured to the bounding sphere of the model)
+        float distance = std::max(glm::length(ourCamera.Position - modelBounds.Center) - modelBounds.Radius, 0.1f);
+        float pixelsPerUnit = currentScreenHeight / (2.0f * distance * tanf(glm::radians(ourCamera.Zoom) / 2.0f));
+        currentLOD = 0;
+
+        while (currentLOD + 1 < LOD_COUNT && (size_t)(currentLOD + 2) * totalSubmeshCount <= indices.size() && lodErrors[currentLOD + 1] * pixelsPerUnit < LOD_PIXEL_ERROR)
+            currentLOD++;
+
+        int firstLODSubmesh = currentLOD * totalSubmeshCount;
+
+        // cull the submeshes outside of the view frustum (the same clip planes as the projection)
+        Frustum frustum(projection * view);
+        std::vector<char> submeshVisible(totalSubmeshCount);
+        culledSubmeshCount = 0;
+
+        for (int i = 0; i < totalSubmeshCount; i++)
+        {
+            submeshVisible[i] = frustum.isVisible(submeshBounds[i]);
+            culledSubmeshCount += !submeshVisible[i];
+        }
+
+        profiler.endScope(SCOPE_UNIFORMS);
+
         // render model
+        profiler.beginScope(SCOPE_DRAW);
         glBindVertexArray(VAO);
 
         if (!displayBaseMesh)
@@ -257,6 +333,9 @@ int main()
 
             for (int i = 0; i < totalSubmeshCount; i++)
             {
+                if (!submeshVisible[i])
+                    continue;
+
                 if (textureCount == totalSubmeshCount)
                 {
                     glActiveTexture(GL_TEXTURE0); // [TODO] textures are assigned to the wrong submeshes
@@ -266,8 +345,7 @@ int main()
                 if (alternativeTextureCount > 0 && textureCount == 1)
                     glBindTexture(GL_TEXTURE_2D, textures[selectedTexture]);
 
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[i]);
-                glDrawElements(GL_TRIANGLES, indices[i].size(), GL_UNSIGNED_SHORT, 0);
+                drawIndexList(firstLODSubmesh + i);
             }
         }
         else
@@ -278,8 +356,10 @@ int main()
 
             for (int i = 0; i < totalSubmeshCount; i++)
             {
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[i]);
-                glDrawElements(GL_TRIANGLES, indices[i].size(), GL_UNSIGNED_SHORT, 0);
+                if (!submeshVisible[i])
+                    continue;
+
+                drawIndexList(firstLODSubmesh + i);
             }
 
             // second pass: render mesh faces
@@ -288,20 +368,35 @@ int main()
 
             for (int i = 0; i < totalSubmeshCount; i++)
             {
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[i]);
-                glDrawElements(GL_TRIANGLES, indices[i].size(), GL_UNSIGNED_SHORT, 0);
+                if (!submeshVisible[i])
+                    continue;
+
+                drawIndexList(firstLODSubmesh + i);
             }
         }
 
         // render light cube
         lightSource.draw(view, projection);
 
+        profiler.endScope(SCOPE_DRAW);
+        profiler.endGPUScope(GPU_SCENE);
+
         // render settings panel (and file browsing dialog, if open)
+        profiler.beginScope(SCOPE_PRESENT);
         ImGui::Render();
+
+        profiler.beginGPUScope(GPU_UI);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        profiler.endGPUScope(GPU_UI);
 
         glfwSwapBuffers(window); // make the contents of the back buffer (stores the completed frames) visible on the screen
-        glfwPollEvents();        // if any events are triggered (like keyboard input or mouse movement events), updates the window state, and calls the corresponding functions (which we can register via callback methods)
+        profiler.endScope(SCOPE_PRESENT);
+
+        profiler.beginScope(SCOPE_INPUT);
+        glfwPollEvents(); // if any events are triggered (like keyboard input or mouse movement events), updates the window state, and calls the corresponding functions (which we can register via callback methods)
+        profiler.endScope(SCOPE_INPUT);
+
+        profiler.endFrame();
     }
 
     // terminate, clearing all previously allocated GLFW resources
@@ -447,7 +542,7 @@ void loadBDAEModel(const char *fpath)
 
     if (!EBOs.empty())
     {
-        glDeleteBuffers(totalSubmeshCount, EBOs.data());
+        glDeleteBuffers(EBOs.size(), EBOs.data());
         EBOs.clear();
     }
 
@@ -459,369 +554,217 @@ void loadBDAEModel(const char *fpath)
 
     vertices.clear();
     indices.clear();
-    fileSize = vertexCount = faceCount = textureCount = alternativeTextureCount = selectedTexture = totalSubmeshCount = 0;
+    drawRanges.clear();
+    fileSize = vertexCount = faceCount = textureCount = alternativeTextureCount = selectedTexture = totalSubmeshCount = currentLOD = 0;
+    submeshBounds.clear();
+    modelBounds = ComputeBounds(NULL, DECODED_VERTEX_SIZE, NULL, 0);
+    culledSubmeshCount = 0;
+    std::fill(lodErrors, lodErrors + LOD_COUNT, 0.0f);
     std::vector<std::string> textureNames;
+    std::vector<int> baseVertices; // first vertex of the mesh of each submesh in the vertex buffer (the index data of a mesh starts from 0)
 
-    // 2. load and parse the .bdae file, building the mesh vertex and index data
-    CPackPatchReader *bdaeArchive = new CPackPatchReader(fpath, true, false);           // open outer .bdae archive file
-    IReadResFile *bdaeFile = bdaeArchive->openFile("little_endian_not_quantized.bdae"); // open inner .bdae file
+    // 2. load and parse the .bdae file, building the mesh vertex and index data (parsed files are shared through the file cache, so a model that was loaded before is not read and parsed again); only the float variant is loaded, as the position scale / bias of the quantized variant is not known yet
+    CCachedFile *cachedFile = CFileCache::getInst()->get(fpath, "little_endian_not_quantized.bdae");
+    bool damaged = (cachedFile && !ModelView(cachedFile->getFile()).IsValid());
 
-    if (bdaeFile)
+    // a model whose mesh tables do not fit in its data is not displayed
+    if (damaged)
     {
-        File myFile;
-        int result = myFile.Init(bdaeFile); // run the parser
+        cachedFile->drop();
+        cachedFile = NULL;
+    }
 
-        std::cout << "\n"
-                  << (result != 1 ? "INITIALIZATION SUCCESS" : "INITIALIZATION ERROR") << std::endl;
+    std::cout << "\n"
+              << (cachedFile ? "INITIALIZATION SUCCESS" : "INITIALIZATION ERROR") << std::endl;
 
-        if (result != 1)
-        {
-            // std::cout << "\nRetrieving model vertex and index data, loading textures.." << std::endl;
+    if (damaged)
+        std::cout << "The meshes of the model lie outside of its data, the file is damaged." << std::endl;
+    else if (!cachedFile)
+        std::cout << "The float variant (little_endian_not_quantized.bdae) could not be loaded; models with only the quantized variant are not supported yet." << std::endl;
 
-            // retrieve the number of meshes, submeshes, and vertex count for each one
-            int meshCount, meshInfoOffset;
-            char *ptr = (char *)myFile.DataBuffer + 80 + 120; // points to mesh info in the Data section
-            memcpy(&meshCount, ptr, sizeof(int));
-            memcpy(&meshInfoOffset, ptr + 4, sizeof(int));
+    if (cachedFile)
+    {
+        const File &myFile = cachedFile->getFile(); // the parsed file is shared with the other users of the cache, so it is read only
 
-            std::cout << "\nMESHES: " << meshCount << std::endl;
+        // std::cout << "\nRetrieving model vertex and index data, loading textures.." << std::endl;
 
-            int meshVertexCount[meshCount], submeshCount[meshCount], meshMetadataOffset[meshCount], meshVertexDataOffset[meshCount];
+        // retrieve the number of meshes, submeshes, and vertex count for each one
+        ModelView model(myFile); // typed view over the Data section
 
-            for (int i = 0; i < meshCount; i++)
-            {
-                memcpy(&meshMetadataOffset[i], ptr + 4 + meshInfoOffset + 20 + i * 24, sizeof(int));
-                memcpy(&meshVertexCount[i], ptr + 4 + meshInfoOffset + 20 + i * 24 + meshMetadataOffset[i] + 4, sizeof(int));
-                memcpy(&submeshCount[i], ptr + 4 + meshInfoOffset + 20 + i * 24 + meshMetadataOffset[i] + 12, sizeof(int));
+        std::cout << "\nMESHES: " << model.GetMeshCount() << std::endl;
 
-                /* [TODO] parse mesh vertex data offset
-
-                memcpy(&meshVertexDataOffset[i], ptr + 4 + meshInfoOffset + 20 + i * 24 + meshMetadataOffset[i] + 88, sizeof(int));
+        for (int i = 0; i < model.GetMeshCount(); i++)
+        {
+            const MeshMetadata &mesh = model.GetMesh(i);
 
-                unsigned char *bytes = reinterpret_cast<unsigned char *>(ptr + 4 + meshInfoOffset + 20 + i * 24 + meshMetadataOffset[i]);
+            // [TODO] parse mesh vertex data offset (at +88 of the mesh metadata)
 
-                for (int i = 0; i < 100; ++i)
-                {
-                    std::cout << std::hex << std::setw(2) << std::setfill('0')
-                              << static_cast<int>(bytes[i]) << " ";
+            std::cout << "[" << i + 1 << "]  " << mesh.VertexCount << " vertices, " << mesh.SubmeshCount << " submeshes" << std::endl;
+        }
 
-                    if ((i + 1) % 16 == 0)
-                        std::cout << "\n";
-                }
-                std::cout << std::dec << std::endl;
+        totalSubmeshCount = model.GetSubmeshCount();
+        indices.resize(totalSubmeshCount);
+        int currentSubmeshIndex = 0;
+        std::vector<MeshRange> meshRanges;
 
-                */
+        // loop through each mesh, retrieve its vertex and index data; all vertex data is stored in a single flat vector, while index data is stored in separate vectors for each submesh
+        for (int i = 0; i < model.GetMeshCount(); i++)
+        {
+            const MeshMetadata &mesh = model.GetMesh(i);
+            ChunkData meshVertexData = model.GetVertexData(i);
+            unsigned int bytesPerVertex = meshVertexData.Size / mesh.VertexCount;
+            VertexFormat format = GetFloatVertexFormat(bytesPerVertex);
 
-                std::cout << "[" << i + 1 << "]  " << meshVertexCount[i] << " vertices, " << submeshCount[i] << " submeshes" << std::endl;
-                totalSubmeshCount += submeshCount[i];
-            }
+            // each vertex is decoded into 3 position, 3 normal, and 2 texture coordinates (X, Y, Z, Nx, Ny, Nz, S, T); in fact, in the .bdae file there are more variables per vertex, that's why bytesPerVertex is more than the size of these attributes
+            size_t firstVertex = vertices.size();
+            vertices.resize(firstVertex + mesh.VertexCount * DECODED_VERTEX_SIZE);
 
-            indices.resize(totalSubmeshCount);
-            int currentSubmeshIndex = 0;
+            if ((int)bytesPerVertex >= GetVertexFormatSize(format))
+                DecodeVertices(format, meshVertexData.Data, mesh.VertexCount, &vertices[firstVertex]);
+            else
+                std::cout << "Mesh " << i + 1 << ": " << bytesPerVertex << " bytes per vertex is too small for its vertex format" << std::endl;
 
-            // loop through each mesh, retrieve its vertex and index data; all vertex data is stored in a single flat vector, while index data is stored in separate vectors for each submesh
-            for (int i = 0; i < meshCount; i++)
+            for (int k = 0; k < mesh.SubmeshCount; k++)
             {
-                unsigned char *meshVertexDataPtr = (unsigned char *)myFile.RemovableBuffers[i + currentSubmeshIndex] + 4;
-                unsigned int meshVertexDataSize = myFile.RemovableBuffersInfo[(i + currentSubmeshIndex) * 2] - 4;
-                unsigned int bytesPerVertex = meshVertexDataSize / meshVertexCount[i];
+                ChunkData submeshIndexData = model.GetIndexData(i, k);
+                unsigned int submeshTriangleCount = submeshIndexData.Size / (3 * sizeof(unsigned short));
 
-                for (int j = 0; j < meshVertexCount[i]; j++)
+                for (int l = 0; l < submeshTriangleCount; l++)
                 {
-                    float vertex[8]; // each vertex has 3 position, 3 normal, and 2 texture coordinates (total of 8 float components; in fact, in the .bdae file there are more than 8 variables per vertex, that's why bytesPerVertex is more than 8 * sizeof(float))
-                    memcpy(vertex, meshVertexDataPtr + j * bytesPerVertex, sizeof(vertex));
-
-                    vertices.push_back(vertex[0]); // X
-                    vertices.push_back(vertex[1]); // Y
-                    vertices.push_back(vertex[2]); // Z
+                    unsigned short triangle[3];
+                    memcpy(triangle, submeshIndexData.Data + l * sizeof(triangle), sizeof(triangle));
 
-                    vertices.push_back(vertex[3]); // Nx
-                    vertices.push_back(vertex[4]); // Ny
-                    vertices.push_back(vertex[5]); // Nz
-
-                    vertices.push_back(vertex[6]); // S
-                    vertices.push_back(vertex[7]); // T
+                    indices[currentSubmeshIndex].push_back(triangle[0]);
+                    indices[currentSubmeshIndex].push_back(triangle[1]);
+                    indices[currentSubmeshIndex].push_back(triangle[2]);
+                    faceCount++;
                 }
 
-                for (int k = 0; k < submeshCount[i]; k++)
-                {
-                    unsigned char *submeshIndexDataPtr = (unsigned char *)myFile.RemovableBuffers[i + currentSubmeshIndex + 1] + 4;
-                    unsigned int submeshIndexDataSize = myFile.RemovableBuffersInfo[(i + currentSubmeshIndex) * 2 + 2] - 4;
-                    unsigned int submeshTriangleCount = submeshIndexDataSize / (3 * sizeof(unsigned short));
-
-                    for (int l = 0; l < submeshTriangleCount; l++)
-                    {
-                        unsigned short triangle[3];
-                        memcpy(triangle, submeshIndexDataPtr + l * sizeof(triangle), sizeof(triangle));
-
-                        indices[currentSubmeshIndex].push_back(triangle[0]);
-                        indices[currentSubmeshIndex].push_back(triangle[1]);
-                        indices[currentSubmeshIndex].push_back(triangle[2]);
-                        faceCount++;
-                    }
-
-                    currentSubmeshIndex++;
-                }
+                currentSubmeshIndex++;
             }
 
-            // search for texture names
-            ptr = (char *)myFile.DataBuffer + 80 + 96;
-            memcpy(&textureCount, ptr, sizeof(int));
-
-            std::cout << "\nTEXTURES: " << ((textureCount != 0) ? std::to_string(textureCount) : "0, file name will be used as a texture name") << std::endl;
-
-            // normalize model path for cross-platform compatibility (Windows uses '\', Linux uses '/')
-            std::string modelPath(fpath);
-            std::replace(modelPath.begin(), modelPath.end(), '\\', '/');
+            MeshRange range = {(int)(firstVertex / DECODED_VERTEX_SIZE), mesh.VertexCount, currentSubmeshIndex - mesh.SubmeshCount, mesh.SubmeshCount};
+            meshRanges.push_back(range);
+        }
 
-            // retrieve model subpath
-            const char *subpathStart = std::strstr(modelPath.c_str(), "/model/") + 7; // subpath starts after '/model/' (texture and model files have the same subpath, e.g. 'creature/pet/')
-            const char *subpathEnd = std::strrchr(modelPath.c_str(), '/') + 1;        // last '/' before the file name
-            std::string textureSubpath(subpathStart, subpathEnd);
+        // merge the duplicate vertices of the meshes (in parallel, one mesh per thread)
+        size_t bytesSaved = WeldMeshes(vertices, DECODED_VERTEX_SIZE, indices, meshRanges, weldEpsilon, (int)std::thread::hardware_concurrency());
 
-            bool isAlphaRef = false;       // for debugging textures
-            bool isUnsortedFolder = false; // for 'unsorted' folder
+        std::cout << "\nWELDING: " << bytesSaved / (DECODED_VERTEX_SIZE * sizeof(float)) << " duplicate vertices merged, " << bytesSaved << " bytes saved" << std::endl;
 
-            if (textureSubpath.rfind("unsorted/", 0) == 0)
-                isUnsortedFolder = true;
+        // reorder the triangles and vertices of each mesh for the vertex cache and the vertex fetch of the GPU
+        for (int i = 0; i < (int)meshRanges.size(); i++)
+        {
+            const MeshRange &range = meshRanges[i];
+            VertexCacheStats before, after;
 
-            // [TODO] implement a more robust approach
-            // loop through each retrieved string and find those that are texture names
-            for (int i = 0, n = myFile.StringStorage.size(); i < n; i++)
-            {
-                std::string s = myFile.StringStorage[i];
+            if (range.VertexCount > 0 && range.SubmeshCount > 0 && OptimizeMesh(&vertices[(size_t)range.FirstVertex * DECODED_VERTEX_SIZE], DECODED_VERTEX_SIZE * sizeof(float), range.VertexCount, &indices[range.FirstSubmesh], range.SubmeshCount, &before, &after))
+                std::cout << "Mesh " << i + 1 << ": ACMR " << before.ACMR << " -> " << after.ACMR << ", ATVR " << before.ATVR << " -> " << after.ATVR << std::endl;
+        }
 
-                if (s == "alpharef")
-                    isAlphaRef = true;
+        // build the levels of detail of the meshes, or read them from the cache file next to the model if it was made from the same mesh data
+        std::string lodCachePath = std::string(fpath) + ".lod";
+        unsigned long long meshHash = HashMeshData(vertices, indices);
+        std::vector<MeshLOD> lods;
+        bool lodsCached = ReadLODCache(lodCachePath.c_str(), meshHash, lods) && lods.size() == meshRanges.size() * (LOD_COUNT - 1);
 
-                // convert to lowercase
-                for (char &c : s)
-                    c = std::tolower(c);
+        for (size_t i = 0; i < lods.size() && lodsCached; i++)
+            lodsCached = ((int)lods[i].SubmeshIndices.size() == meshRanges[i / (LOD_COUNT - 1)].SubmeshCount);
 
-                // remove 'avatar/' if it exists
-                int avatarPos = s.find("avatar/");
-                if (avatarPos != std::string::npos && !isUnsortedFolder)
-                    s.erase(avatarPos, 7);
+        if (!lodsCached)
+        {
+            lods.assign(meshRanges.size() * (LOD_COUNT - 1), MeshLOD());
 
-                // remove 'texture/' if it exists
-                if (s.rfind("texture/", 0) == 0)
-                    s.erase(0, 8);
+            for (size_t i = 0; i < meshRanges.size(); i++)
+            {
+                const MeshRange &range = meshRanges[i];
+                BuildMeshLODs(&vertices[(size_t)range.FirstVertex * DECODED_VERTEX_SIZE], DECODED_VERTEX_SIZE, range.VertexCount, &indices[range.FirstSubmesh], range.SubmeshCount, &lods[i * (LOD_COUNT - 1)]);
 
-                // a string is a texture file name if it ends with '.tga' and doesn't start with '_'
-                if (s.length() >= 4 && s.compare(s.length() - 4, 4, ".tga") == 0 && s[0] != '_' && s.substr(0, 3) != "e:/")
-                {
-                    // replace the ending with '.png'
-                    s.replace(s.length() - 4, 4, ".png");
-
-                    // build final path
-                    if (!isUnsortedFolder)
-                        s = "texture/" + textureSubpath + s;
-                    else
-                        s = "texture/unsorted/" + s;
-
-                    // ensure it is a unique texture name
-                    if (std::find(textureNames.begin(), textureNames.end(), s) == textureNames.end())
-                        textureNames.push_back(s);
-                }
+                for (int level = 0; level < LOD_COUNT - 1; level++)
+                    for (int k = 0; k < range.SubmeshCount; k++)
+                        OptimizeVertexCache(lods[i * (LOD_COUNT - 1) + level].SubmeshIndices[k], range.VertexCount);
             }
 
-            // set file info to be displayed in the settings panel
-            fileName = modelPath.substr(modelPath.find_last_of("/\\") + 1); // file name is after the last path separator in the full path
-            fileSize = myFile.Size;
-            vertexCount = vertices.size() / 8;
+            if (!WriteLODCache(lodCachePath.c_str(), meshHash, lods))
+                std::cout << "\nLevels of detail could not be cached to " << lodCachePath << std::endl;
+        }
 
-            // if a texture file matching the model file name exists, override the parsed texture (for single-texture models only)
-            std::string s = "texture/" + textureSubpath + fileName;
-            s.replace(s.length() - 5, 5, ".png");
+        // the submeshes of the levels follow the full resolution ones in the index array
+        indices.resize(totalSubmeshCount * LOD_COUNT);
 
-            if (textureCount == 1 && std::filesystem::exists(s))
+        for (size_t i = 0; i < meshRanges.size(); i++)
+        {
+            for (int level = 1; level < LOD_COUNT; level++)
             {
-                textureNames.clear();
-                textureNames.push_back(s);
-            }
+                MeshLOD &lod = lods[i * (LOD_COUNT - 1) + level - 1];
+                lodErrors[level] = std::max(lodErrors[level], lod.Error);
 
-            // if a texture name is missing in the .bdae file, use this file's name instead (assuming the texture file was manually found and named)
-            if (textureNames.empty())
-            {
-                textureNames.push_back(s);
-                textureCount++;
+                for (int k = 0; k < meshRanges[i].SubmeshCount; k++)
+                    indices[level * totalSubmeshCount + meshRanges[i].FirstSubmesh + k].swap(lod.SubmeshIndices[k]);
             }
+        }
 
-            for (int i = 0; i < textureNames.size(); i++)
-                std::cout << "[" << i + 1 << "]  " << textureNames[i] << std::endl;
-
-            // search for alternative texture files
-            // [TODO] handle for multi-texture models
-            if (textureNames.size() == 1 && std::filesystem::exists(textureNames[0]) && !isUnsortedFolder)
-            {
-                std::filesystem::path texturePath("texture/" + textureSubpath);
-                std::string baseTextureName = std::filesystem::path(textureNames[0]).stem().string(); // texture file name without extension or folder (e.g. 'boar_01' or 'puppy_bear_black')
-
-                std::string groupName; // name shared by a group of related textures
-
-                // naming rule #1
-                if (baseTextureName.find("lvl") != std::string::npos && baseTextureName.find("world") != std::string::npos)
-                    groupName = baseTextureName;
+        std::cout << "\nLEVELS OF DETAIL" << (lodsCached ? " (cached)" : "") << ":";
 
-                // naming rule #2
-                for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(texturePath))
-                {
-                    if (!entry.is_regular_file())
-                        continue;
+        for (int level = 0; level < LOD_COUNT; level++)
+        {
+            size_t lodFaceCount = 0;
 
-                    std::filesystem::path entryPath = entry.path();
+            for (int i = 0; i < totalSubmeshCount; i++)
+                lodFaceCount += indices[level * totalSubmeshCount + i].size() / 3;
 
-                    if (entryPath.extension() != ".png")
-                        continue;
+            std::cout << " " << lodFaceCount << (level + 1 < LOD_COUNT ? "," : " faces");
+        }
 
-                    std::string baseEntryName = entryPath.stem().string();
+        std::cout << std::endl;
 
-                    if (baseEntryName.rfind(baseTextureName + '_', 0) == 0 &&                                  // starts with '<baseTextureName>_'
-                        baseEntryName.size() > baseTextureName.size() + 1 &&                                   // has at least one character after the underscore
-                        std::isdigit(static_cast<unsigned char>(baseEntryName[baseTextureName.size() + 1])) && // first character after '_' is a digit
-                        entryPath.string() != textureNames[0])                                                 // not the original base texture itself
-                    {
-                        groupName = baseTextureName;
-                        break;
-                    }
-                }
+        // bounds of the submeshes and of the model, then place the camera in front of the model
+        submeshBounds.resize(totalSubmeshCount);
+        baseVertices.assign(totalSubmeshCount, 0);
+        bool boundsEmpty = true;
 
-                // for a numeric suffix (e.g. '_01', '_2'), remove it if exists (to derive a group name for searching potential alternative textures, e.g 'boar')
-                if (groupName.empty())
-                {
-                    auto lastUnderscore = baseTextureName.rfind('_');
-
-                    if (lastUnderscore != std::string::npos)
-                    {
-                        std::string afterLastUnderscore = baseTextureName.substr(lastUnderscore + 1);
+        for (size_t i = 0; i < meshRanges.size(); i++)
+        {
+            const float *meshVertices = vertices.data() + (size_t)meshRanges[i].FirstVertex * DECODED_VERTEX_SIZE;
 
-                        if (!afterLastUnderscore.empty() && std::all_of(afterLastUnderscore.begin(), afterLastUnderscore.end(), ::isdigit))
-                            groupName = baseTextureName.substr(0, lastUnderscore);
-                    }
-                }
+            for (int k = meshRanges[i].FirstSubmesh; k < meshRanges[i].FirstSubmesh + meshRanges[i].SubmeshCount; k++)
+            {
+                submeshBounds[k] = ComputeBounds(meshVertices, DECODED_VERTEX_SIZE, indices[k].data(), indices[k].size());
+                baseVertices[k] = meshRanges[i].FirstVertex;
 
-                // for a non numeric‑suffix (e.g. '_black'), use the “max‑match” approach to find the best group name
-                if (groupName.empty())
+                if (!indices[k].empty())
                 {
-                    // build a list of all possible prefixes (e.g. 'puppy_black_bear', 'puppy_black', 'puppy')
-                    std::vector<std::string> prefixes;
-                    std::string s = baseTextureName;
-
-                    while (true)
-                    {
-                        prefixes.push_back(s);
-                        auto pos = s.rfind('_');
-
-                        if (pos == std::string::npos)
-                            break;
-
-                        s.resize(pos); // remove the last '_suffix'
-                    }
-
-                    // try each prefix and find the one that gives the highest number of matching texture files
-                    int bestCount = 0;
-
-                    for (int i = 0, n = prefixes.size(); i < n; i++)
-                    {
-                        int count = 0;
-                        std::string pref = prefixes[i];
-
-                        // skip single-word prefixes ('puppy' cannot be a group name, otherwise puppy_wolf.png could be an alternative)
-                        if (pref.find('_') == std::string::npos)
-                            continue;
-
-                        // loop through each file in the texture directory and count how many .png files start with '<pref>_'
-                        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(texturePath))
-                        {
-                            if (!entry.is_regular_file())
-                                continue;
-
-                            std::filesystem::path entryPath = entry.path();
-
-                            if (entryPath.extension() != ".png")
-                                continue;
-
-                            if (entryPath.stem().string().rfind(pref + '_', 0) == 0)
-                                count++;
-                        }
-
-                        // compare and update the best count; if two prefixes match the same number of textures, prefer the longer one
-                        if (count > bestCount || (count == bestCount && pref.length() > groupName.length()))
-                        {
-                            bestCount = count;
-                            groupName = pref;
-                        }
-                    }
+                    modelBounds = (boundsEmpty ? submeshBounds[k] : MergeBounds(modelBounds, submeshBounds[k]));
+                    boundsEmpty = false;
                 }
+            }
+        }
 
-                // finally, collect textures based on the best group name
-                if (!groupName.empty())
-                {
-                    std::vector<std::string> found;
-
-                    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(texturePath))
-                    {
-                        if (!entry.is_regular_file())
-                            continue;
-
-                        std::filesystem::path entryPath = entry.path();
-
-                        if (entryPath.extension() != ".png")
-                            continue;
-
-                        // skip the file if its name doesn't exactly match the group name, and doesn’t start with the group name followed by an underscore.
-                        if (!(entryPath.stem().string() == groupName || entryPath.stem().string().rfind(groupName + '_', 0) == 0))
-                            continue;
-
-                        std::string alternativeTextureName = "texture/" + textureSubpath + entryPath.filename().string();
-
-                        // skip the original base texture (already in textureNames[0])
-                        if (alternativeTextureName == textureNames[0])
-                            continue;
+        ourCamera.Frame(modelBounds.Center, modelBounds.Radius);
 
-                        // ensure it is a unique texture name
-                        if (std::find(textureNames.begin(), textureNames.end(), alternativeTextureName) == textureNames.end())
-                        {
-                            found.push_back(alternativeTextureName);
-                            alternativeTextureCount++;
-                        }
-                    }
+        // search for texture names
+        textureCount = model.GetTextureCount();
 
-                    if (!found.empty())
-                    {
-                        // append and report
-                        textureNames.insert(textureNames.end(), found.begin(), found.end());
+        std::cout << "\nTEXTURES: " << ((textureCount != 0) ? std::to_string(textureCount) : "0, file name will be used as a texture name") << std::endl;
 
-                        std::cout << "Found " << found.size() << " alternative(s) for '" << groupName << "':\n";
+        alternativeTextureCount = FindTextureNames(fpath, myFile, textureCount, textureNames);
 
-                        for (int i = 0; i < found.size(); i++)
-                            std::cout << "  " << found[i] << "\n";
-                    }
-                    else
-                        std::cout << "No alternatives found for group '" << groupName << "'\n";
-                }
-                else
-                    std::cout << "No valid grouping name for '" << baseTextureName << "'\n";
-            }
+        // set file info to be displayed in the settings panel
+        std::string modelPath(fpath);
+        std::replace(modelPath.begin(), modelPath.end(), '\\', '/');
 
-            // if (isAlphaRef)
-            //     std::cout << "\nALPHAREF" << std::endl;
-        }
+        fileName = modelPath.substr(modelPath.find_last_of("/\\") + 1); // file name is after the last path separator in the full path
+        fileSize = myFile.Size;
+        vertexCount = vertices.size() / 8;
 
-        free(myFile.DataBuffer);
-        delete[] static_cast<char *>(myFile.RemovableBuffers[0]);
-        delete[] myFile.RemovableBuffers;
-        delete[] myFile.RemovableBuffersInfo;
+        cachedFile->drop();
     }
 
-    delete bdaeFile;
-    delete bdaeArchive;
-
     // 3. setup buffers
-    EBOs.resize(totalSubmeshCount);
+    EBOs.resize(indices.size());
     glGenVertexArrays(1, &VAO);                   // generate a Vertex Attribute Object to store vertex attribute configurations
     glGenBuffers(1, &VBO);                        // generate a Vertex Buffer Object to store vertex data
-    glGenBuffers(totalSubmeshCount, EBOs.data()); // generate an Element Buffer Object for each submesh to store index data
+    glGenBuffers(EBOs.size(), EBOs.data());       // generate an Element Buffer Object for each submesh (at each level of detail) to store index data
 
     glBindVertexArray(VAO); // bind the VAO first so that subsequent VBO bindings and vertex attribute configurations are stored in it correctly
 
@@ -835,12 +778,52 @@ void loadBDAEModel(const char *fpath)
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    for (int i = 0; i < totalSubmeshCount; i++)
+    // the index lists are relative to the first vertex of their mesh; they are offset to index the whole vertex buffer, in 16 bits when the largest index fits (the common case), in 32 bits otherwise
+    drawRanges.resize(indices.size());
+    int wideIndexListCount = 0;
+
+    for (int i = 0; i < (int)indices.size(); i++)
     {
+        const std::vector<unsigned short> &list = indices[i];
+        int baseVertex = baseVertices.empty() ? 0 : baseVertices[i % totalSubmeshCount];
+        int largestIndex = list.empty() ? 0 : baseVertex + *std::max_element(list.begin(), list.end());
+
+        drawRanges[i].IndexCount = list.size();
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[i]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices[i].size() * sizeof(unsigned short), indices[i].data(), GL_STATIC_DRAW);
+
+        if (largestIndex <= 0xFFFF)
+        {
+            drawRanges[i].IndexType = GL_UNSIGNED_SHORT;
+
+            if (baseVertex == 0)
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, list.size() * sizeof(unsigned short), list.data(), GL_STATIC_DRAW);
+            else
+            {
+                std::vector<unsigned short> offsetList(list);
+
+                for (size_t j = 0; j < offsetList.size(); j++)
+                    offsetList[j] += baseVertex;
+
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, offsetList.size() * sizeof(unsigned short), offsetList.data(), GL_STATIC_DRAW);
+            }
+        }
+        else
+        {
+            drawRanges[i].IndexType = GL_UNSIGNED_INT;
+            wideIndexListCount++;
+
+            std::vector<unsigned int> offsetList(list.begin(), list.end());
+
+            for (size_t j = 0; j < offsetList.size(); j++)
+                offsetList[j] += baseVertex;
+
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, offsetList.size() * sizeof(unsigned int), offsetList.data(), GL_STATIC_DRAW);
+        }
     }
 
+    if (wideIndexListCount > 0)
+        std::cout << "\n" << wideIndexListCount << " of " << indices.size() << " index lists use 32-bit indices (" << vertexCount << " vertices)" << std::endl;
+
     // 4. load texture(s)
     textures.resize(textureNames.size());
     glGenTextures(textureNames.size(), textures.data()); // generate and store texture ID(s)
@@ -874,3 +857,11 @@ void loadBDAEModel(const char *fpath)
 
     modelLoaded = true;
 }
+
+// draw an index list (a submesh at a level of detail) with the index type chosen on upload
+void drawIndexList(int index)
+{
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[index]);
+    glDrawElements(GL_TRIANGLES, drawRanges[index].IndexCount, drawRanges[index].IndexType, 0);
+    profiler.countDraw(drawRanges[index].IndexCount);
+}
@@ -0,0 +1,456 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <pthread.h>
+#include "meshOptimize.h"
+
+// size of the cache modeled by the optimization (larger than the simulated cache, so that the order also suits larger caches)
+#define OPTIMIZER_CACHE_SIZE 32
+
+//! Measures the vertex cache efficiency of the submeshes of a mesh.
+// ________________________________________________________________
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned short> *submeshIndices, int submeshCount, int vertexCount)
+{
+    std::vector<unsigned int> cachedAt(vertexCount, 0); // time a vertex entered the cache + 1 (0: never)
+    unsigned int time = 0;
+    size_t misses = 0, triangles = 0;
+
+    for (int s = 0; s < submeshCount; s++)
+    {
+        const std::vector<unsigned short> &indices = submeshIndices[s];
+        unsigned int flushTime = time; // the cache is empty at the beginning of each submesh
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3, triangles++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned short v = indices[i + k];
+
+                if (v >= vertexCount)
+                    continue;
+
+                // FIFO: a vertex stays in the cache for the next VERTEX_CACHE_SIZE misses
+                if (cachedAt[v] <= flushTime || time - cachedAt[v] >= VERTEX_CACHE_SIZE)
+                {
+                    cachedAt[v] = ++time;
+                    misses++;
+                }
+            }
+        }
+    }
+
+    VertexCacheStats stats;
+    stats.ACMR = (triangles ? (float)misses / triangles : 0.0f);
+    stats.ATVR = (vertexCount ? (float)misses / vertexCount : 0.0f);
+    return stats;
+}
+
+// number of remaining triangle counts with a precomputed score
+#define OPTIMIZER_VALENCE_TABLE_SIZE 32
+
+// precomputed parts of the vertex score
+struct VertexScoreTables
+{
+    float Cache[OPTIMIZER_CACHE_SIZE + 1]; // by cache position + 1 (0: not in the cache)
+    float Valence[OPTIMIZER_VALENCE_TABLE_SIZE];
+
+    VertexScoreTables()
+    {
+        Cache[0] = 0.0f;
+
+        for (int i = 0; i < OPTIMIZER_CACHE_SIZE; i++)
+            Cache[i + 1] = (i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (OPTIMIZER_CACHE_SIZE - 3), 1.5f));
+
+        for (int i = 1; i < OPTIMIZER_VALENCE_TABLE_SIZE; i++)
+            Valence[i] = 2.0f / sqrtf((float)i);
+    }
+};
+
+// score of a vertex: high for vertices in the front of the cache (the 3 of the last triangle score a bit less, so that the order doesn't get stuck in strips) and for vertices with few triangles left
+static float VertexScore(int cachePosition, int remainingTriangles)
+{
+    static const VertexScoreTables tables;
+
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float valence = (remainingTriangles < OPTIMIZER_VALENCE_TABLE_SIZE ? tables.Valence[remainingTriangles] : 2.0f / sqrtf((float)remainingTriangles));
+    return tables.Cache[cachePosition + 1] + valence;
+}
+
+//! Reorders the triangles of a submesh for the post-transform vertex cache (Tom Forsyth's algorithm: greedily emits the triangle whose vertices have the best score, updating the scores of the vertices in the modeled cache only).
+// ___________________________________________________________________________________________________________________________________________________________________________________________________________________
+
+void OptimizeVertexCache(std::vector<unsigned short> &indices, int vertexCount)
+{
+    int triangleCount = indices.size() / 3;
+
+    if (triangleCount < 2)
+        return;
+
+    // 1. Triangles of each vertex.
+    std::vector<int> remaining(vertexCount, 0);
+
+    for (int i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+
+    std::vector<int> firstTriangle(vertexCount + 1, 0);
+
+    for (int v = 0; v < vertexCount; v++)
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+
+    std::vector<int> adjacency(triangleCount * 3);
+    std::vector<int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+
+    for (int t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[filled[indices[t * 3 + k]]++] = t;
+
+    // 2. Initial scores.
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    std::vector<float> triangleScore(triangleCount, 0.0f);
+    std::vector<char> emitted(triangleCount, 0);
+
+    for (int v = 0; v < vertexCount; v++)
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+
+    for (int t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            triangleScore[t] += vertexScore[indices[t * 3 + k]];
+
+    int best = std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin();
+
+    // 3. Emit the triangles.
+    std::vector<unsigned short> result;
+    result.reserve(triangleCount * 3);
+
+    int cache[OPTIMIZER_CACHE_SIZE + 3];
+    int cacheSize = 0;
+    int cursor = 0; // first triangle that might not be emitted yet (used when no triangle in the cache is left)
+
+    for (int n = 0; n < triangleCount; n++)
+    {
+        if (best < 0)
+        {
+            while (emitted[cursor])
+                cursor++;
+
+            best = cursor;
+        }
+
+        emitted[best] = 1;
+
+        int newCache[OPTIMIZER_CACHE_SIZE + 3];
+        int newCacheSize = 0;
+
+        for (int k = 0; k < 3; k++)
+        {
+            int v = indices[best * 3 + k];
+            result.push_back((unsigned short)v);
+
+            // remove the triangle from the triangles of its vertex
+            int *begin = &adjacency[firstTriangle[v]];
+            int *end = begin + remaining[v];
+            std::iter_swap(std::find(begin, end, best), end - 1);
+            remaining[v]--;
+
+            newCache[newCacheSize++] = v;
+        }
+
+        // the vertices of the triangle move to the front of the cache, the others are pushed back
+        for (int i = 0; i < cacheSize; i++)
+        {
+            int v = cache[i];
+
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+                newCache[newCacheSize++] = v;
+        }
+
+        // update the scores of the vertices in the cache (and of those pushed out of it) and of their triangles
+        for (int i = 0; i < newCacheSize; i++)
+        {
+            int v = newCache[i];
+            cachePosition[v] = (i < OPTIMIZER_CACHE_SIZE ? i : -1);
+
+            float score = VertexScore(cachePosition[v], remaining[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+
+            for (int j = firstTriangle[v]; j < firstTriangle[v] + remaining[v]; j++)
+                triangleScore[adjacency[j]] += delta;
+        }
+
+        // the next triangle is the best one among the triangles of the cached vertices
+        best = -1;
+        float bestScore = -1.0f;
+
+        for (int i = 0; i < std::min(newCacheSize, OPTIMIZER_CACHE_SIZE); i++)
+        {
+            int v = newCache[i];
+
+            for (int j = firstTriangle[v]; j < firstTriangle[v] + remaining[v]; j++)
+            {
+                int t = adjacency[j];
+
+                if (triangleScore[t] > bestScore)
+                {
+                    best = t;
+                    bestScore = triangleScore[t];
+                }
+            }
+        }
+
+        cacheSize = std::min(newCacheSize, OPTIMIZER_CACHE_SIZE);
+        memcpy(cache, newCache, cacheSize * sizeof(int));
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+//! Reorders the vertices of a mesh in the order of their first use.
+// _________________________________________________________________
+
+void OptimizeVertexFetch(void *vertexData, int vertexSize, int vertexCount, std::vector<unsigned short> *submeshIndices, int submeshCount)
+{
+    std::vector<int> remap(vertexCount, -1); // new index of each vertex
+    int next = 0;
+
+    for (int s = 0; s < submeshCount; s++)
+    {
+        std::vector<unsigned short> &indices = submeshIndices[s];
+
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            if (remap[indices[i]] < 0)
+                remap[indices[i]] = next++;
+
+            indices[i] = (unsigned short)remap[indices[i]];
+        }
+    }
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] < 0)
+            remap[v] = next++;
+    }
+
+    unsigned char *data = static_cast<unsigned char *>(vertexData);
+    std::vector<unsigned char> original(data, data + (size_t)vertexCount * vertexSize);
+
+    for (int v = 0; v < vertexCount; v++)
+        memcpy(data + (size_t)remap[v] * vertexSize, &original[(size_t)v * vertexSize], vertexSize);
+}
+
+bool OptimizeMesh(void *vertexData, int vertexSize, int vertexCount, std::vector<unsigned short> *submeshIndices, int submeshCount, VertexCacheStats *before, VertexCacheStats *after)
+{
+    // validity check: every index refers to a vertex of the mesh
+    for (int s = 0; s < submeshCount; s++)
+    {
+        if (!submeshIndices[s].empty() && *std::max_element(submeshIndices[s].begin(), submeshIndices[s].end()) >= vertexCount)
+            return false;
+    }
+
+    if (before)
+        *before = AnalyzeVertexCache(submeshIndices, submeshCount, vertexCount);
+
+    for (int s = 0; s < submeshCount; s++)
+        OptimizeVertexCache(submeshIndices[s], vertexCount);
+
+    OptimizeVertexFetch(vertexData, vertexSize, vertexCount, submeshIndices, submeshCount);
+
+    if (after)
+        *after = AnalyzeVertexCache(submeshIndices, submeshCount, vertexCount);
+
+    return true;
+}
+
+// hash of the bytes of a vertex (FNV-1a)
+static unsigned int HashVertex(const unsigned char *vertex, int vertexSize)
+{
+    unsigned int hash = 2166136261u;
+
+    for (int i = 0; i < vertexSize; i++)
+        hash = (hash ^ vertex[i]) * 16777619u;
+
+    return hash;
+}
+
+//! Merges the equal vertices of a mesh.
+// ____________________________________
+
+int WeldVertices(void *vertexData, int vertexSize, int vertexCount, std::vector<unsigned short> *submeshIndices, int submeshCount, float epsilon)
+{
+    if (vertexCount <= 0)
+        return 0;
+
+    // validity check: every index refers to a vertex of the mesh
+    for (int s = 0; s < submeshCount; s++)
+    {
+        if (!submeshIndices[s].empty() && *std::max_element(submeshIndices[s].begin(), submeshIndices[s].end()) >= vertexCount)
+            return vertexCount;
+    }
+
+    unsigned char *data = static_cast<unsigned char *>(vertexData);
+
+    // 1. Keys of the vertices: their bytes, or with a tolerance, their float components rounded to multiples of it.
+    std::vector<unsigned char> keys;
+    int keySize = vertexSize;
+
+    if (epsilon > 0.0f)
+    {
+        int componentCount = vertexSize / sizeof(float);
+        keySize = componentCount * sizeof(long long);
+        keys.resize((size_t)vertexCount * keySize);
+
+        for (int v = 0; v < vertexCount; v++)
+        {
+            for (int c = 0; c < componentCount; c++)
+            {
+                float value;
+                memcpy(&value, data + (size_t)v * vertexSize + c * sizeof(float), sizeof(float));
+
+                double rounded = floor((double)value / epsilon + 0.5);
+                long long cell;
+
+                if (fabs(rounded) < 4e18)
+                    cell = (long long)rounded;
+                else
+                {
+                    // (infinite, NaN, or out of range of the cells: only bit-identical values are merged)
+                    unsigned int bits;
+                    memcpy(&bits, &value, sizeof(bits));
+                    cell = (long long)bits | (1LL << 62);
+                }
+
+                memcpy(&keys[(size_t)v * keySize + c * sizeof(long long)], &cell, sizeof(long long));
+            }
+        }
+    }
+
+    unsigned char *key = (keys.empty() ? data : &keys[0]);
+
+    // 2. Find the first vertex with the same key of each vertex (open addressing hash table of the new vertex indices; the kept vertices and their keys are moved down over the merged ones).
+    size_t tableSize = 1;
+
+    while (tableSize < (size_t)vertexCount * 2)
+        tableSize *= 2;
+
+    std::vector<int> table(tableSize, -1);
+    std::vector<int> remap(vertexCount); // new index of each vertex
+    int uniqueCount = 0;
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        const unsigned char *vertexKey = key + (size_t)v * keySize;
+        size_t slot = HashVertex(vertexKey, keySize) & (tableSize - 1);
+
+        while (table[slot] >= 0 && memcmp(key + (size_t)table[slot] * keySize, vertexKey, keySize) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] < 0)
+        {
+            if (uniqueCount != v)
+            {
+                memcpy(data + (size_t)uniqueCount * vertexSize, data + (size_t)v * vertexSize, vertexSize);
+
+                if (!keys.empty())
+                    memcpy(key + (size_t)uniqueCount * keySize, vertexKey, keySize);
+            }
+
+            table[slot] = uniqueCount++;
+        }
+
+        remap[v] = table[slot];
+    }
+
+    // 3. Update the indices.
+    for (int s = 0; s < submeshCount; s++)
+    {
+        std::vector<unsigned short> &indices = submeshIndices[s];
+
+        for (size_t i = 0; i < indices.size(); i++)
+            indices[i] = (unsigned short)remap[indices[i]];
+    }
+
+    return uniqueCount;
+}
+
+// state shared by the welding threads
+struct WeldJob
+{
+    float *Vertices;
+    int VertexSize;
+    std::vector<unsigned short> *Indices;
+    std::vector<MeshRange> *Meshes;
+    std::vector<int> WeldedCounts; // vertex count of each mesh after welding
+    float Epsilon;
+    std::atomic<size_t> Next; // next mesh to weld
+};
+
+static void *WeldThread(void *arg)
+{
+    WeldJob *job = static_cast<WeldJob *>(arg);
+
+    for (size_t i = job->Next++; i < job->Meshes->size(); i = job->Next++)
+    {
+        const MeshRange &mesh = (*job->Meshes)[i];
+        job->WeldedCounts[i] = WeldVertices(job->Vertices + (size_t)mesh.FirstVertex * job->VertexSize, job->VertexSize * sizeof(float), mesh.VertexCount, job->Indices + mesh.FirstSubmesh, mesh.SubmeshCount, job->Epsilon);
+    }
+
+    return NULL;
+}
+
+//! Welds the meshes of a model in parallel.
+// _________________________________________
+
+size_t WeldMeshes(std::vector<float> &vertices, int vertexSize, std::vector<std::vector<unsigned short>> &indices, std::vector<MeshRange> &meshes, float epsilon, int threadCount)
+{
+    if (meshes.empty())
+        return 0;
+
+    // 1. Weld each mesh in its part of the vertex array.
+    WeldJob job;
+    job.Vertices = &vertices[0];
+    job.VertexSize = vertexSize;
+    job.Indices = (indices.empty() ? NULL : &indices[0]);
+    job.Meshes = &meshes;
+    job.WeldedCounts.resize(meshes.size());
+    job.Epsilon = epsilon;
+    job.Next = 0;
+
+    threadCount = std::max(1, std::min<int>(threadCount, (int)meshes.size()));
+    std::vector<pthread_t> threads;
+
+    for (int i = 1; i < threadCount; ++i)
+    {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, WeldThread, &job) == 0)
+            threads.push_back(thread);
+    }
+
+    WeldThread(&job); // (the calling thread is one of the workers)
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+
+    // 2. Move the welded meshes down to close the gaps.
+    size_t oldSize = vertices.size();
+    int nextVertex = 0;
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (meshes[i].FirstVertex != nextVertex)
+            memmove(&vertices[(size_t)nextVertex * vertexSize], &vertices[(size_t)meshes[i].FirstVertex * vertexSize], (size_t)job.WeldedCounts[i] * vertexSize * sizeof(float));
+
+        meshes[i].FirstVertex = nextVertex;
+        meshes[i].VertexCount = job.WeldedCounts[i];
+        nextVertex += job.WeldedCounts[i];
+    }
+
+    vertices.resize((size_t)nextVertex * vertexSize);
+    return (oldSize - vertices.size()) * sizeof(float);
+}
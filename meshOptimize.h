@@ -0,0 +1,52 @@
+#ifndef __MESHOPTIMIZE_H_INCLUDED__
+#define __MESHOPTIMIZE_H_INCLUDED__
+
+#include <vector>
+
+/*
+    Reordering of the extracted meshes for faster rendering (used by the viewer and the exporter).
+    The triangles of each submesh are reordered so that consecutive triangles share vertices that are still in the post-transform vertex cache of the GPU (Tom Forsyth's linear-speed vertex cache optimization), then the vertices of the mesh are reordered in the order the triangles use them, so that the vertex fetch reads memory sequentially.
+    The result is measured by simulating a FIFO vertex cache:
+        ACMR (average cache miss ratio) – transformed vertices per triangle (3 at worst, about 0.5 at best for a regular grid)
+        ATVR (average transformed vertex ratio) – transformed vertices per vertex of the mesh (1 at best)
+    Before that, the vertices that are equal (bit-identical, or with a tolerance, equal after rounding their float components to multiples of it) can be merged, as the meshes often repeat vertices along their texture and normal seams.
+    ________________________________________________________________________________________________________________________________________
+*/
+
+// size of the simulated FIFO vertex cache (the size of the post-transform cache of most GPUs)
+#define VERTEX_CACHE_SIZE 16
+
+struct VertexCacheStats
+{
+    float ACMR;
+    float ATVR;
+};
+
+// simulates the vertex cache over the submeshes of a mesh (the cache is flushed between submeshes, which are drawn separately)
+VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned short> *submeshIndices, int submeshCount, int vertexCount);
+
+// reorders the triangles of the submesh for the vertex cache
+void OptimizeVertexCache(std::vector<unsigned short> &indices, int vertexCount);
+
+// reorders the vertices of a mesh (vertexCount vertices of vertexSize bytes) in the order its submeshes use them, and updates the indices; unused vertices are moved to the end
+void OptimizeVertexFetch(void *vertexData, int vertexSize, int vertexCount, std::vector<unsigned short> *submeshIndices, int submeshCount);
+
+// both of the above for a mesh; returns false (and changes nothing) if an index is out of range
+bool OptimizeMesh(void *vertexData, int vertexSize, int vertexCount, std::vector<unsigned short> *submeshIndices, int submeshCount, VertexCacheStats *before = 0, VertexCacheStats *after = 0);
+
+// merges the equal vertices of a mesh (with epsilon > 0, the vertices are vertexSize / 4 floats compared with that tolerance) and updates the indices; the kept vertices are moved to the beginning in their original order; returns the new vertex count (the vertex count if an index is out of range, with nothing changed)
+int WeldVertices(void *vertexData, int vertexSize, int vertexCount, std::vector<unsigned short> *submeshIndices, int submeshCount, float epsilon = 0.0f);
+
+// part of a mesh in the vertex array (in vertices) and in the submesh index array of a model
+struct MeshRange
+{
+    int FirstVertex;
+    int VertexCount;
+    int FirstSubmesh;
+    int SubmeshCount;
+};
+
+// welds the meshes of a model (vertices of vertexSize floats) with threadCount threads, then removes the merged vertices from the array and updates the ranges; returns the number of bytes saved
+size_t WeldMeshes(std::vector<float> &vertices, int vertexSize, std::vector<std::vector<unsigned short>> &indices, std::vector<MeshRange> &meshes, float epsilon, int threadCount);
+
+#endif
@@ -0,0 +1,459 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "meshSimplify.h"
+
+// meshes with fewer triangles are not simplified further
+#define SIMPLIFY_MIN_TRIANGLES 32
+
+// symmetric 4x4 matrix of a sum of squared plane distances: (a, b, c, d) planes summed as their outer products
+struct Quadric
+{
+    double A00, A11, A22, A01, A02, A12; // (a, b, c) part
+    double B0, B1, B2;                   // d * (a, b, c)
+    double C;                            // d * d
+
+    void addPlane(double a, double b, double c, double d)
+    {
+        A00 += a * a, A11 += b * b, A22 += c * c;
+        A01 += a * b, A02 += a * c, A12 += b * c;
+        B0 += a * d, B1 += b * d, B2 += c * d;
+        C += d * d;
+    }
+
+    void add(const Quadric &q)
+    {
+        A00 += q.A00, A11 += q.A11, A22 += q.A22;
+        A01 += q.A01, A02 += q.A02, A12 += q.A12;
+        B0 += q.B0, B1 += q.B1, B2 += q.B2;
+        C += q.C;
+    }
+
+    // sum of squared distances of the point to the planes
+    double evaluate(const float *p) const
+    {
+        double x = p[0], y = p[1], z = p[2];
+        double result = A00 * x * x + A11 * y * y + A22 * z * z + 2 * (A01 * x * y + A02 * x * z + A12 * y * z) + 2 * (B0 * x + B1 * y + B2 * z) + C;
+        return std::max(result, 0.0);
+    }
+};
+
+// unnormalized normal of a triangle
+static void TriangleNormal(const float *a, const float *b, const float *c, double *normal)
+{
+    double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// possible collapse of a vertex into a neighbour
+struct Collapse
+{
+    int From;
+    int To;
+    double Cost;
+};
+
+//! Simplifies a mesh with quadric error metrics.
+// _______________________________________________
+
+float SimplifyMesh(const float *vertices, int vertexSize, int vertexCount, const std::vector<unsigned short> *submeshIndices, int submeshCount, float targetRatio, std::vector<unsigned short> *result)
+{
+    // 1. Triangles of all submeshes, with their submesh.
+    std::vector<int> triangles; // (3 indices, submesh) per triangle
+
+    for (int s = 0; s < submeshCount; s++)
+    {
+        for (size_t i = 0; i + 2 < submeshIndices[s].size(); i += 3)
+        {
+            int triangle[4] = {submeshIndices[s][i], submeshIndices[s][i + 1], submeshIndices[s][i + 2], s};
+
+            if (triangle[0] < vertexCount && triangle[1] < vertexCount && triangle[2] < vertexCount)
+                triangles.insert(triangles.end(), triangle, triangle + 4);
+        }
+    }
+
+    auto position = [&](int v) { return vertices + (size_t)v * vertexSize; };
+
+    size_t triangleCount = triangles.size() / 4;
+
+    if (triangleCount == 0)
+    {
+        for (int s = 0; s < submeshCount; s++)
+            result[s].clear();
+
+        return 0.0f;
+    }
+
+    size_t targetCount = (size_t)(triangleCount * targetRatio);
+    double maxCost = 0.0;
+
+    // 2. Locked vertices: on a seam (sharing the position of another vertex), on a border (edge of one triangle only), or on a submesh boundary.
+    std::vector<char> locked(vertexCount, 0);
+    std::vector<int> byPosition(vertexCount);
+
+    for (int v = 0; v < vertexCount; v++)
+        byPosition[v] = v;
+
+    std::sort(byPosition.begin(), byPosition.end(), [&](int a, int b) { return memcmp(position(a), position(b), 3 * sizeof(float)) < 0; });
+
+    for (int i = 1; i < vertexCount; i++)
+    {
+        if (memcmp(position(byPosition[i - 1]), position(byPosition[i]), 3 * sizeof(float)) == 0)
+            locked[byPosition[i - 1]] = locked[byPosition[i]] = 1;
+    }
+
+    std::vector<unsigned int> edges; // (smaller index << 16 | larger index) of each triangle edge
+    std::vector<int> vertexSubmesh(vertexCount, -1);
+
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = triangles[t * 4 + k], b = triangles[t * 4 + (k + 1) % 3];
+            edges.push_back(std::min(a, b) << 16 | std::max(a, b));
+
+            int &submesh = vertexSubmesh[a];
+
+            if (submesh >= 0 && submesh != triangles[t * 4 + 3])
+                locked[a] = 1;
+
+            submesh = triangles[t * 4 + 3];
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t j = i + 1;
+
+        while (j < edges.size() && edges[j] == edges[i])
+            j++;
+
+        if (j - i == 1)
+            locked[edges[i] >> 16] = locked[edges[i] & 0xFFFF] = 1;
+
+        i = j;
+    }
+
+    // 3. Quadrics of the vertices: the planes of their triangles.
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const int *triangle = &triangles[t * 4];
+        double normal[3];
+        TriangleNormal(position(triangle[0]), position(triangle[1]), position(triangle[2]), normal);
+
+        double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+        if (length == 0.0)
+            continue;
+
+        double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+        const float *p = position(triangle[0]);
+        double d = -(a * p[0] + b * p[1] + c * p[2]);
+
+        for (int k = 0; k < 3; k++)
+            quadrics[triangle[k]].addPlane(a, b, c, d);
+    }
+
+    // 4. Collapse the cheapest edges in passes, until the target is reached or nothing can be collapsed.
+    std::vector<int> remap(vertexCount);
+    std::vector<char> touched(vertexCount);
+    std::vector<int> firstTriangle(vertexCount + 1), adjacency;
+    std::vector<Collapse> collapses;
+
+    while (triangleCount > targetCount)
+    {
+        // triangles of each vertex
+        std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+
+        for (size_t i = 0; i < triangleCount * 4; i++)
+        {
+            if (i % 4 != 3)
+                firstTriangle[triangles[i] + 1]++;
+        }
+
+        for (int v = 0; v < vertexCount; v++)
+            firstTriangle[v + 1] += firstTriangle[v];
+
+        adjacency.resize(triangleCount * 3);
+        std::vector<int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+                adjacency[filled[triangles[t * 4 + k]]++] = t;
+
+        // possible collapses along the edges, cheapest first
+        collapses.clear();
+
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                int a = triangles[t * 4 + k], b = triangles[t * 4 + (k + 1) % 3];
+
+                if (!locked[a])
+                {
+                    Collapse collapse = {a, b, quadrics[a].evaluate(position(b))};
+                    collapses.push_back(collapse);
+                }
+
+                if (!locked[b])
+                {
+                    Collapse collapse = {b, a, quadrics[b].evaluate(position(a))};
+                    collapses.push_back(collapse);
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.Cost < b.Cost; });
+
+        // each collapse removes about 2 triangles; the vertices around a collapse are not touched again in the same pass, so that the flip checks stay valid
+        size_t collapseLimit = (triangleCount - targetCount) / 2 + 1;
+        size_t collapseCount = 0;
+
+        for (int v = 0; v < vertexCount; v++)
+            remap[v] = v;
+
+        std::fill(touched.begin(), touched.end(), 0);
+
+        for (size_t i = 0; i < collapses.size() && collapseCount < collapseLimit; i++)
+        {
+            int from = collapses[i].From, to = collapses[i].To;
+
+            if (touched[from] || touched[to])
+                continue;
+
+            // the triangles that stay must not flip over
+            bool flips = false;
+
+            for (int j = firstTriangle[from]; j < firstTriangle[from + 1] && !flips; j++)
+            {
+                const int *triangle = &triangles[adjacency[j] * 4];
+
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                    continue;
+
+                const float *before[3], *after[3];
+
+                for (int k = 0; k < 3; k++)
+                {
+                    before[k] = position(triangle[k]);
+                    after[k] = position(triangle[k] == from ? to : triangle[k]);
+                }
+
+                double normalBefore[3], normalAfter[3];
+                TriangleNormal(before[0], before[1], before[2], normalBefore);
+                TriangleNormal(after[0], after[1], after[2], normalAfter);
+
+                flips = (normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] + normalBefore[2] * normalAfter[2] <= 0.0);
+            }
+
+            if (flips)
+                continue;
+
+            remap[from] = to;
+            quadrics[to].add(quadrics[from]);
+            maxCost = std::max(maxCost, collapses[i].Cost);
+            collapseCount++;
+
+            for (int j = firstTriangle[from]; j < firstTriangle[from + 1]; j++)
+                for (int k = 0; k < 3; k++)
+                    touched[triangles[adjacency[j] * 4 + k]] = 1;
+        }
+
+        if (collapseCount == 0)
+            break;
+
+        // apply the collapses and remove the triangles that became degenerate
+        size_t kept = 0;
+
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            int a = remap[triangles[t * 4]], b = remap[triangles[t * 4 + 1]], c = remap[triangles[t * 4 + 2]];
+
+            if (a == b || b == c || c == a)
+                continue;
+
+            triangles[kept * 4] = a;
+            triangles[kept * 4 + 1] = b;
+            triangles[kept * 4 + 2] = c;
+            triangles[kept * 4 + 3] = triangles[t * 4 + 3];
+            kept++;
+        }
+
+        triangleCount = kept;
+    }
+
+    // 5. Index lists of the submeshes.
+    for (int s = 0; s < submeshCount; s++)
+        result[s].clear();
+
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            result[triangles[t * 4 + 3]].push_back((unsigned short)triangles[t * 4 + k]);
+
+    return (float)sqrt(maxCost);
+}
+
+//! Builds the level of detail chain of a mesh.
+// ____________________________________________
+
+void BuildMeshLODs(const float *vertices, int vertexSize, int vertexCount, const std::vector<unsigned short> *submeshIndices, int submeshCount, MeshLOD *lods)
+{
+    const std::vector<unsigned short> *previous = submeshIndices;
+    float previousError = 0.0f;
+
+    for (int level = 0; level < LOD_COUNT - 1; level++)
+    {
+        MeshLOD &lod = lods[level];
+        lod.SubmeshIndices.assign(previous, previous + submeshCount);
+        lod.Error = previousError;
+
+        size_t indexCount = 0;
+
+        for (int s = 0; s < submeshCount; s++)
+            indexCount += previous[s].size();
+
+        // (each level is made from the previous one, which is faster and keeps the levels consistent; the error of the chain is the largest of its steps)
+        if (indexCount / 3 >= SIMPLIFY_MIN_TRIANGLES)
+            lod.Error = std::max(previousError, SimplifyMesh(vertices, vertexSize, vertexCount, previous, submeshCount, 0.5f, lod.SubmeshIndices.data()));
+
+        previous = lod.SubmeshIndices.data();
+        previousError = lod.Error;
+    }
+}
+
+// adds bytes to a hash (FNV-1a, 64-bit)
+static void HashBytes(unsigned long long &hash, const void *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ static_cast<const unsigned char *>(data)[i]) * 1099511628211ull;
+}
+
+//! Hashes the data of the meshes of a model.
+// __________________________________________
+
+unsigned long long HashMeshData(const std::vector<float> &vertices, const std::vector<std::vector<unsigned short>> &indices)
+{
+    // the vertex data, then each index list with its size
+    unsigned long long hash = 14695981039346656037ull;
+    HashBytes(hash, vertices.data(), vertices.size() * sizeof(float));
+
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int size = indices[i].size();
+        HashBytes(hash, &size, sizeof(size));
+        HashBytes(hash, indices[i].data(), size * sizeof(unsigned short));
+    }
+
+    return hash;
+}
+
+// header of a level of detail cache file; it is followed by the levels, each as its error, its submesh count, and the index count and indices of each submesh
+struct LODCacheHeader
+{
+    char Magic[4]; // 'BLOD'
+    unsigned int Version;
+    unsigned long long Hash; // hash of the mesh data the levels were made from
+    unsigned int LevelCount;
+    unsigned int Reserved;
+};
+
+#define LOD_CACHE_VERSION 1
+
+//! Reads the levels of detail of a model from its cache file.
+// ___________________________________________________________
+
+bool ReadLODCache(const char *path, unsigned long long hash, std::vector<MeshLOD> &lods)
+{
+    FILE *in = fopen(path, "rb");
+
+    if (!in)
+        return false;
+
+    LODCacheHeader header;
+    bool valid = fread(&header, sizeof(header), 1, in) == 1 && memcmp(header.Magic, "BLOD", 4) == 0 && header.Version == LOD_CACHE_VERSION && header.Hash == hash;
+
+    if (valid)
+    {
+        fseek(in, 0, SEEK_END);
+        long fileSize = ftell(in);
+        fseek(in, sizeof(header), SEEK_SET);
+
+        // (every count is checked against the file size, so that a damaged file can't cause huge allocations)
+        valid = header.LevelCount <= (unsigned long)fileSize / 8;
+
+        if (valid)
+            lods.resize(header.LevelCount);
+
+        for (unsigned int i = 0; i < header.LevelCount && valid; i++)
+        {
+            unsigned int submeshCount;
+            valid = fread(&lods[i].Error, sizeof(float), 1, in) == 1 && fread(&submeshCount, sizeof(submeshCount), 1, in) == 1 && submeshCount <= (unsigned long)fileSize / 4;
+
+            if (valid)
+                lods[i].SubmeshIndices.assign(submeshCount, std::vector<unsigned short>());
+
+            for (unsigned int s = 0; s < submeshCount && valid; s++)
+            {
+                unsigned int indexCount;
+                valid = fread(&indexCount, sizeof(indexCount), 1, in) == 1 && indexCount <= (unsigned long)fileSize / 2;
+
+                if (valid && indexCount)
+                {
+                    lods[i].SubmeshIndices[s].resize(indexCount);
+                    valid = fread(&lods[i].SubmeshIndices[s][0], indexCount * sizeof(unsigned short), 1, in) == 1;
+                }
+            }
+        }
+    }
+
+    fclose(in);
+
+    if (!valid)
+        lods.clear();
+
+    return valid;
+}
+
+//! Writes the levels of detail of a model to its cache file.
+// __________________________________________________________
+
+bool WriteLODCache(const char *path, unsigned long long hash, const std::vector<MeshLOD> &lods)
+{
+    FILE *out = fopen(path, "wb");
+
+    if (!out)
+        return false;
+
+    LODCacheHeader header = {{'B', 'L', 'O', 'D'}, LOD_CACHE_VERSION, hash, (unsigned int)lods.size(), 0};
+    bool written = fwrite(&header, sizeof(header), 1, out) == 1;
+
+    for (size_t i = 0; i < lods.size() && written; i++)
+    {
+        unsigned int submeshCount = lods[i].SubmeshIndices.size();
+        written = fwrite(&lods[i].Error, sizeof(float), 1, out) == 1 && fwrite(&submeshCount, sizeof(submeshCount), 1, out) == 1;
+
+        for (unsigned int s = 0; s < submeshCount && written; s++)
+        {
+            const std::vector<unsigned short> &indices = lods[i].SubmeshIndices[s];
+            unsigned int indexCount = indices.size();
+            written = fwrite(&indexCount, sizeof(indexCount), 1, out) == 1 && (indexCount == 0 || fwrite(&indices[0], indexCount * sizeof(unsigned short), 1, out) == 1);
+        }
+    }
+
+    written = (fclose(out) == 0) && written;
+
+    if (!written)
+        remove(path);
+
+    return written;
+}
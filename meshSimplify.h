@@ -0,0 +1,40 @@
+#ifndef __MESHSIMPLIFY_H_INCLUDED__
+#define __MESHSIMPLIFY_H_INCLUDED__
+
+#include <vector>
+
+/*
+    Level of detail chains of the extracted meshes (used by the viewer).
+    Each level is made from the previous one by edge collapses ordered by quadric error metrics (Garland and Heckbert): every vertex accumulates the planes of its triangles, and collapsing it into a neighbour costs the sum of squared distances from the neighbour's position to those planes.
+    The vertices themselves are not changed – a level is only a new set of index lists into the vertex data of the mesh, so all levels share its vertex buffer.
+    Vertices that lie on a border, on a texture / normal seam (another vertex at the same position), or on the boundary of a submesh never move, so the levels keep their outline, UV layout, and submesh split.
+    The levels can be stored in a cache file next to the model, checked against a hash of the mesh data they were made from.
+    ________________________________________________________________________________________________________________________________________
+*/
+
+// number of levels of detail of a mesh, including the full resolution one
+#define LOD_COUNT 4
+
+// a level of detail of a mesh: the index lists of its submeshes, and the largest error of its collapses (distance in model units)
+struct MeshLOD
+{
+    float Error;
+    std::vector<std::vector<unsigned short>> SubmeshIndices;
+};
+
+// simplifies a mesh (vertices of vertexSize floats, starting with the position) to about targetRatio of its triangles; writes the index lists of the submeshes to result and returns the error
+float SimplifyMesh(const float *vertices, int vertexSize, int vertexCount, const std::vector<unsigned short> *submeshIndices, int submeshCount, float targetRatio, std::vector<unsigned short> *result);
+
+// builds the levels 1 .. LOD_COUNT - 1 of a mesh, each with about half the triangles of the previous one (the errors grow along the chain)
+void BuildMeshLODs(const float *vertices, int vertexSize, int vertexCount, const std::vector<unsigned short> *submeshIndices, int submeshCount, MeshLOD *lods);
+
+// hash of the vertex and index data the levels are made from
+unsigned long long HashMeshData(const std::vector<float> &vertices, const std::vector<std::vector<unsigned short>> &indices);
+
+// reads the levels of the meshes of a model from a cache file (LOD_COUNT - 1 per mesh); returns false if there is no valid cache for the hash
+bool ReadLODCache(const char *path, unsigned long long hash, std::vector<MeshLOD> &lods);
+
+// writes the levels of the meshes of a model to a cache file; returns false on failure
+bool WriteLODCache(const char *path, unsigned long long hash, const std::vector<MeshLOD> &lods);
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef __MODELVIEW_H_INCLUDED__
+#define __MODELVIEW_H_INCLUDED__
+
+#include <cstddef>
+#include <vector>
+#include "resFile.h"
+
+/*
+    Typed views over the Data section of a parsed .bdae model.
+    The layout structs below are laid directly over the loaded data, so reading a field is a single load from memory instead of a memcpy at a hand-computed offset.
+    The tables and offsets followed by ModelView are checked against the bounds of the loaded data once, when the view is created; a damaged model gives an invalid view (IsValid() is false) with no meshes and no textures.
+    ________________________________________________________________________________________________________________________________________
+*/
+
+// Data section layout (offsets from the beginning of the Data section, i.e. right after the header)
+// __________________________________________________________________________________________________
+
+// mesh metadata, referenced by a mesh table entry
+struct MeshMetadata
+{
+    int Unknown0;     // +0
+    int VertexCount;  // +4  number of vertices of the mesh
+    int Unknown8;     // +8
+    int SubmeshCount; // +12 number of submeshes (index buffers) of the mesh
+};
+
+// mesh table entry
+struct MeshEntry
+{
+    char Unknown0[20];                     // +0
+    RelativeAccess<MeshMetadata> Metadata; // +20
+};
+
+// table stored as a number of entries followed by a relative offset to the first entry
+template <typename T>
+struct Table
+{
+    int Count;
+    RelativeAccess<T> Entries;
+};
+
+struct ModelData
+{
+    char Unknown0[96];       // +0
+    int TextureCount;        // +96  number of textures used by the model
+    char Unknown100[20];     // +100
+    Table<MeshEntry> Meshes; // +120 mesh table
+};
+
+static_assert(sizeof(MeshMetadata) == 16, "MeshMetadata layout");
+static_assert(sizeof(MeshEntry) == 24, "MeshEntry layout");
+static_assert(offsetof(ModelData, TextureCount) == 96, "ModelData layout");
+static_assert(offsetof(ModelData, Meshes) == 120, "ModelData layout");
+
+// contents of a removable chunk (without the 4-byte value that precedes the vertex / index data)
+struct ChunkData
+{
+    const unsigned char *Data;
+    unsigned int Size;
+};
+
+/*
+    Navigation over a parsed model: meshes, their vertex data and the index data of their submeshes.
+    Each mesh stores its vertex data in one removable chunk, followed by one chunk per submesh with its index data; the chunk of each mesh is computed once when the view is created, so any mesh or submesh is found in O(1).
+    The view does not own the File, which must stay loaded while the view is used.
+*/
+
+class ModelView
+{
+public:
+    explicit ModelView(const File &file)
+        : Source(file), Valid(false), Data(NULL), Meshes(NULL)
+    {
+        const FileHeaderData *header = file.ptr();
+
+        Begin = static_cast<const char *>(file.DataBuffer);
+        End = Begin + file.SizeUnRemovable - file.SizeOffsetStringTables; // the main buffer holds everything but the tables and the removable chunks
+        FirstChunk.push_back(0);
+
+        const ModelData *data = reinterpret_cast<const ModelData *>(Begin + header->sizeOfHeader);
+
+        if (!Contains(data, sizeof(ModelData)) || data->Meshes.Count < 0 || !Contains(data->Meshes.Entries.ptr(), (size_t)data->Meshes.Count * sizeof(MeshEntry)))
+            return;
+
+        // removable chunk of the vertex data of each mesh (the chunks of its submeshes follow it); every mesh and every chunk it uses must be in the file
+        const MeshEntry *meshes = data->Meshes.Entries.ptr();
+        int chunkCount = (file.RemovableBuffers ? file.NbRemovableBuffers : 0);
+
+        for (int i = 0; i < data->Meshes.Count; i++)
+        {
+            const MeshMetadata *metadata = meshes[i].Metadata.ptr();
+
+            if (!Contains(metadata, sizeof(MeshMetadata)) || metadata->SubmeshCount < 0 || metadata->SubmeshCount >= chunkCount - FirstChunk[i])
+            {
+                FirstChunk.resize(1);
+                return;
+            }
+
+            FirstChunk.push_back(FirstChunk[i] + 1 + metadata->SubmeshCount);
+        }
+
+        for (int chunk = 0; chunk < FirstChunk.back(); chunk++)
+        {
+            if (file.RemovableBuffersInfo[chunk * 2] < 4)
+            {
+                FirstChunk.resize(1);
+                return;
+            }
+        }
+
+        Valid = true;
+        Data = data;
+        Meshes = meshes;
+    }
+
+    // false if the tables of the model do not fit in its data (the view then has no meshes and no textures)
+    bool IsValid() const { return Valid; }
+
+    int GetTextureCount() const { return Valid ? Data->TextureCount : 0; }
+
+    int GetMeshCount() const { return (int)FirstChunk.size() - 1; }
+
+    // total number of submeshes of all meshes
+    int GetSubmeshCount() const { return FirstChunk.back() - GetMeshCount(); }
+
+    // (mesh and submesh are indices below GetMeshCount() and the SubmeshCount of the mesh)
+    const MeshMetadata &GetMesh(int mesh) const { return *Meshes[mesh].Metadata.ptr(); }
+
+    ChunkData GetVertexData(int mesh) const { return GetChunk(FirstChunk[mesh]); }
+
+    ChunkData GetIndexData(int mesh, int submesh) const { return GetChunk(FirstChunk[mesh] + 1 + submesh); }
+
+private:
+    ChunkData GetChunk(int chunk) const
+    {
+        ChunkData data;
+        data.Data = static_cast<const unsigned char *>(Source.RemovableBuffers[chunk]) + 4;
+        data.Size = Source.RemovableBuffersInfo[chunk * 2] - 4;
+        return data;
+    }
+
+    bool Contains(const void *p, size_t size) const
+    {
+        const char *c = static_cast<const char *>(p);
+        return c >= Begin && c <= End && size <= (size_t)(End - c);
+    }
+
+    const File &Source;
+    bool Valid;
+    const char *Begin; // bounds of the main buffer
+    const char *End;
+    const ModelData *Data;
+    const MeshEntry *Meshes;
+    std::vector<int> FirstChunk; // FirstChunk[i] = removable chunk with the vertex data of mesh i (FirstChunk[meshCount] = number of chunks used)
+};
+
+#endif
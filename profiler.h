@@ -0,0 +1,214 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cfloat>
+
+// CPU scopes of a frame
+enum Profiler_Scope
+{
+    SCOPE_INPUT,    // keyboard input and window events
+    SCOPE_UI,       // building the ImGui panels (including model loading started from them)
+    SCOPE_UNIFORMS, // matrices, uniforms, level of detail selection and culling
+    SCOPE_DRAW,     // draw call submission
+    SCOPE_PRESENT,  // ImGui rendering and buffer swap
+    SCOPE_COUNT
+};
+
+// GPU scopes of a frame (measured with GL_TIME_ELAPSED queries, which can't be nested, so the scopes follow each other)
+enum Profiler_GPUScope
+{
+    GPU_SCENE, // model and light cube
+    GPU_UI,    // ImGui
+    GPU_SCOPE_COUNT
+};
+
+const char *const SCOPE_NAMES[SCOPE_COUNT] = {"Input", "UI build", "Uniforms", "Draw submit", "Present"};
+const char *const GPU_SCOPE_NAMES[GPU_SCOPE_COUNT] = {"GPU scene", "GPU UI"};
+
+const int PROFILER_HISTORY = 240; // frames kept for the graphs
+const int PROFILER_BUFFERS = 2;   // query objects per GPU scope: a query is read back 2 frames after it was issued, so reading it doesn't wait for the GPU
+
+class Profiler
+{
+public:
+    // results of the last completed frame (GPU times arrive PROFILER_BUFFERS frames later)
+    float FrameTime;
+    float ScopeTimes[SCOPE_COUNT];
+    float GPUTimes[GPU_SCOPE_COUNT];
+    int DrawCalls;
+    int Triangles;
+    bool GPUTimingSupported;
+
+    Profiler() : FrameTime(0.0f), DrawCalls(0), Triangles(0), GPUTimingSupported(false), frameIndex(0), historyOffset(0), drawCallCount(0), triangleCount(0)
+    {
+        std::fill(ScopeTimes, ScopeTimes + SCOPE_COUNT, 0.0f);
+        std::fill(GPUTimes, GPUTimes + GPU_SCOPE_COUNT, 0.0f);
+        std::fill(scopeDurations, scopeDurations + SCOPE_COUNT, 0.0);
+        std::fill(&frameHistory[0], &frameHistory[0] + PROFILER_HISTORY, 0.0f);
+        std::fill(&scopeHistory[0][0], &scopeHistory[0][0] + SCOPE_COUNT * PROFILER_HISTORY, 0.0f);
+        std::fill(&gpuHistory[0][0], &gpuHistory[0][0] + GPU_SCOPE_COUNT * PROFILER_HISTORY, 0.0f);
+        std::fill(&queryPending[0][0], &queryPending[0][0] + GPU_SCOPE_COUNT * PROFILER_BUFFERS, false);
+    }
+
+    //! Creates the GPU queries (needs the OpenGL context); without timer query support (no counter bits, as some drivers report) only CPU times are recorded.
+    void init()
+    {
+        GLint counterBits = 0;
+
+        if (GLAD_GL_VERSION_3_3)
+            glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &counterBits);
+
+        GPUTimingSupported = (counterBits > 0);
+
+        if (GPUTimingSupported)
+            glGenQueries(GPU_SCOPE_COUNT * PROFILER_BUFFERS, &queries[0][0]);
+    }
+
+    //! Starts a frame: reads back the GPU queries of PROFILER_BUFFERS frames ago, if their results are available.
+    void beginFrame()
+    {
+        frameStart = std::chrono::steady_clock::now();
+        std::fill(scopeDurations, scopeDurations + SCOPE_COUNT, 0.0);
+        drawCallCount = triangleCount = 0;
+
+        int slot = frameIndex % PROFILER_BUFFERS;
+
+        for (int i = 0; i < GPU_SCOPE_COUNT && GPUTimingSupported; i++)
+        {
+            if (!queryPending[i][slot])
+                continue;
+
+            GLint available = 0;
+            glGetQueryObjectiv(queries[i][slot], GL_QUERY_RESULT_AVAILABLE, &available);
+
+            // (a result that is still not available is dropped rather than waited for; the query is reused)
+            if (available)
+            {
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(queries[i][slot], GL_QUERY_RESULT, &nanoseconds);
+                GPUTimes[i] = nanoseconds / 1.0e6f;
+            }
+
+            queryPending[i][slot] = false;
+        }
+    }
+
+    void beginScope(Profiler_Scope scope)
+    {
+        scopeStart[scope] = std::chrono::steady_clock::now();
+    }
+
+    void endScope(Profiler_Scope scope)
+    {
+        scopeDurations[scope] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scopeStart[scope]).count();
+    }
+
+    void beginGPUScope(Profiler_GPUScope scope)
+    {
+        if (GPUTimingSupported)
+            glBeginQuery(GL_TIME_ELAPSED, queries[scope][frameIndex % PROFILER_BUFFERS]);
+    }
+
+    void endGPUScope(Profiler_GPUScope scope)
+    {
+        if (!GPUTimingSupported)
+            return;
+
+        glEndQuery(GL_TIME_ELAPSED);
+        queryPending[scope][frameIndex % PROFILER_BUFFERS] = true;
+    }
+
+    //! Counts a draw call of the given number of indices (triangles).
+    void countDraw(int indexCount)
+    {
+        drawCallCount++;
+        triangleCount += indexCount / 3;
+    }
+
+    //! Ends a frame: publishes its results and adds them to the graphs.
+    void endFrame()
+    {
+        FrameTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        DrawCalls = drawCallCount;
+        Triangles = triangleCount;
+
+        frameHistory[historyOffset] = FrameTime;
+
+        for (int i = 0; i < SCOPE_COUNT; i++)
+            scopeHistory[i][historyOffset] = ScopeTimes[i] = (float)scopeDurations[i];
+
+        for (int i = 0; i < GPU_SCOPE_COUNT; i++)
+            gpuHistory[i][historyOffset] = GPUTimes[i];
+
+        historyOffset = (historyOffset + 1) % PROFILER_HISTORY;
+        frameIndex++;
+    }
+
+    //! Shows the results in a collapsible panel: frame time, CPU and GPU scopes with their rolling graphs, draw calls and triangles.
+    void drawPanel(float x, float y)
+    {
+        ImGui::SetNextWindowPos(ImVec2(x, y), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(300.0f, 0.0f), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+
+        if (ImGui::Begin("Profiler"))
+        {
+            ImGui::Text("Frame: %.2f ms (%.0f FPS)", FrameTime, FrameTime > 0.0f ? 1000.0f / FrameTime : 0.0f);
+            plot("##frame", frameHistory);
+
+            ImGui::Text("Draw calls: %d", DrawCalls);
+            ImGui::Text("Triangles: %d", Triangles);
+
+            if (ImGui::CollapsingHeader("CPU", ImGuiTreeNodeFlags_DefaultOpen))
+            {
+                for (int i = 0; i < SCOPE_COUNT; i++)
+                {
+                    ImGui::Text("%s: %.3f ms", SCOPE_NAMES[i], ScopeTimes[i]);
+                    plot(SCOPE_NAMES[i], scopeHistory[i]);
+                }
+            }
+
+            if (ImGui::CollapsingHeader("GPU", ImGuiTreeNodeFlags_DefaultOpen))
+            {
+                if (!GPUTimingSupported)
+                    ImGui::TextWrapped("Timer queries are not supported by the driver.");
+
+                for (int i = 0; i < GPU_SCOPE_COUNT && GPUTimingSupported; i++)
+                {
+                    ImGui::Text("%s: %.3f ms", GPU_SCOPE_NAMES[i], GPUTimes[i]);
+                    plot(GPU_SCOPE_NAMES[i], gpuHistory[i]);
+                }
+            }
+        }
+
+        ImGui::End();
+    }
+
+private:
+    std::chrono::steady_clock::time_point frameStart;
+    std::chrono::steady_clock::time_point scopeStart[SCOPE_COUNT];
+    double scopeDurations[SCOPE_COUNT]; // (a scope can be entered more than once per frame)
+
+    GLuint queries[GPU_SCOPE_COUNT][PROFILER_BUFFERS];
+    bool queryPending[GPU_SCOPE_COUNT][PROFILER_BUFFERS];
+    unsigned int frameIndex;
+
+    float frameHistory[PROFILER_HISTORY];
+    float scopeHistory[SCOPE_COUNT][PROFILER_HISTORY];
+    float gpuHistory[GPU_SCOPE_COUNT][PROFILER_HISTORY];
+    int historyOffset; // oldest entry of the histories (the next one to be written)
+
+    int drawCallCount, triangleCount; // of the current frame
+
+    //! Draws a rolling graph of a history, scaled from 0 to its largest value.
+    void plot(const char *label, const float *history)
+    {
+        float largest = *std::max_element(history, history + PROFILER_HISTORY);
+        ImGui::PushID(label);
+        ImGui::PlotLines("", history, PROFILER_HISTORY, historyOffset, NULL, 0.0f, std::max(largest, 0.001f), ImVec2(-1.0f, 30.0f));
+        ImGui::PopID();
+    }
+};
+
+#endif
@@ -1,114 +1,129 @@
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include "resFile.h"
-#include "libs/io/PackPatchReader.h"
+#include "libs/io/CIndexedPackPatchReader.h"
+#include "resFileManager.h"
+#include "bresFormat.h"
 
-int File::SizeOfHeader = 0;
+thread_local int File::SizeOfHeader = 0;
 
 bool File::ExtractStringTable = true;
+bool File::Quiet = false;
 
-// metadata storage based on reference type: index 0 = internal, index 1 = external
-int File::ExternalFileOffsetTableSize[2] = {0, 0};
-int File::ExternalFileStringTableSize[2] = {0, 0};
-char *File::ExternalFilePtr[2] = {0, 0};
+//! Returns the stream the parser logs to.
+// ______________________________________
+
+std::ostream &File::Log()
+{
+    // (one discarding stream per thread: writing to a stream without buffer sets its state, so it is not shared between threads)
+    static thread_local std::ostream discard(NULL);
+
+    return Quiet ? discard : std::cout;
+}
 
 //! Reads raw binary data from .bdae file and loads its sections into memory.
 // __________________________________________________________________________
 
-int File::Init(IReadResFile *file)
+int File::Init(IReadResFile *file, CIndexedPackPatchReader *archive)
 {
-    std::cout << "[Init] Starting File::Init..\n"
-              << std::endl;
-    std::cout << "---------------" << std::endl;
-    std::cout << "[Init] PART 1. \n       Reading raw binary data from .bdae file and loading its sections into memory." << std::endl;
-    std::cout << "---------------\n\n"
-              << std::endl;
-
-    // 1. Read Header data as a structure.
+    Log() << "[Init] Starting File::Init..\n"
+          << std::endl;
+    Log() << "---------------" << std::endl;
+    Log() << "[Init] PART 1. \n       Reading raw binary data from .bdae file and loading its sections into memory." << std::endl;
+    Log() << "---------------\n\n"
+          << std::endl;
+
+    // 1. Read Header data as a structure. Its beginning tells the subversion of the file (byte order and size of the offsets), which selects the conversion of the header to the in-memory form.
     Size = file->getSize();
     int headerSize = sizeof(struct FileHeaderData);
     struct FileHeaderData *header = new FileHeaderData;
 
-    std::cout << "[Init] Header size (size of struct): " << headerSize << std::endl;
-    std::cout << "[Init] File size (length of file): " << Size << std::endl;
-    std::cout << "[Init] File name: " << file->getFileName() << std::endl;
-    std::cout << "\n[Init] At position " << file->getPos() << ", reading header.." << std::endl;
+    Log() << "[Init] Header size (size of struct): " << headerSize << std::endl;
+    Log() << "[Init] File size (length of file): " << Size << std::endl;
+    Log() << "[Init] File name: " << file->getFileName() << std::endl;
+    Log() << "\n[Init] At position " << file->getPos() << ", reading header.." << std::endl;
 
-    int readSize = file->read(header, headerSize);
+    unsigned char rawHeader[sizeof(FileHeaderLayout<uint64_t>)];
+    const BRESVariantFunctions *variant = NULL;
 
-    std::cout << "_________________" << std::endl;
-    std::cout << "\nFile Header Data\n"
-              << std::endl;
-    std::cout << "Signature: " << std::hex << ((char *)&header->signature)[0] << ((char *)&header->signature)[1] << ((char *)&header->signature)[2] << ((char *)&header->signature)[3] << std::dec << std::endl;
-    std::cout << "Endian check: " << header->endianCheck << std::endl;
-    std::cout << "Version: " << header->version << std::endl;
-    std::cout << "Header size: " << header->sizeOfHeader << std::endl;
-    std::cout << "File size: " << header->sizeOfFile << std::endl;
-    std::cout << "Number of offsets: " << header->numOffsets << std::endl;
-    std::cout << "Origin: " << header->origin << std::endl;
-    std::cout << "\nSection offsets  " << std::endl;
-    std::cout << "Offset Data:   " << header->offsets.m_offset << std::endl;
-    std::cout << "String Data:   " << header->stringData.m_offset << std::endl;
-    std::cout << "Data:          " << header->data.m_offset << std::endl;
-    std::cout << "Related files: " << header->relatedFiles.m_offset << std::endl;
-    std::cout << "Removable:     " << header->removable.m_offset << std::endl;
-    std::cout << "\nSize of Removable Chunk: " << header->sizeOfRemovableChunk << std::endl;
-    std::cout << "Number of Removable Chunks: " << header->nbOfRemovableChunks << std::endl;
-    std::cout << "Use separated allocation: " << ((header->useSeparatedAllocationForRemovableBuffers > 0) ? "Yes" : "No") << std::endl;
-    std::cout << "Size of Dynamic Chunk: " << header->sizeOfDynamicChunk << std::endl;
-    std::cout << "________________________\n"
-              << std::endl;
-
-    // 2. Search for related files.
-    unsigned int beginOfRelatedFiles = header->relatedFiles.m_offset - header->origin;
+    if (file->read(rawHeader, BRES_DETECT_SIZE) == BRES_DETECT_SIZE)
+        variant = DetectBRESVariant(rawHeader);
 
-    if (header->origin == 0)
+    if (!variant)
     {
-        std::cout << "[Init] At position " << beginOfRelatedFiles << ", checking for related filenames.." << std::endl;
-
-        // read name size of the related file
-        int sizeOfName = 0;
-        file->seek(beginOfRelatedFiles);
-        file->read(&sizeOfName, 4);
-
-        unsigned char *bytes = reinterpret_cast<unsigned char *>(&sizeOfName);
-        std::cout << "[Init] Size of related filename: ";
-        for (int i = 0; i < 4; ++i)
-            std::cout << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(bytes[i]) << " ";
-
-        std::cout << std::dec;
-        std::cout << "(" << sizeOfName << " byte)" << std::endl;
+        Log() << "[Init] Error: unknown byte order mark or header size, this is not a .bdae file!" << std::endl;
+        delete header;
+        return 1;
+    }
 
-        // validity check: name size should not exceed the limit for filename length
-        if (sizeOfName > 256)
-            std::cout << "[Init] Warning: sizeOfName exceeds buffer size!" << std::endl;
+    Log() << "[Init] Subversion: " << variant->Name << std::endl;
 
-        // validity check: name is real (size 1 means none)
-        if (sizeOfName > 1)
-        {
-            // read name of the related file
-            beginOfRelatedFiles += 4;
-            char relatedFileName[256];
-            file->seek(beginOfRelatedFiles);
-            file->read(relatedFileName, (sizeOfName + 3) & ~3); // align to next 4 bytes, as name size may not be a multiple of 4
+    // the data is laid out for the pointer size of the engine the file was written for
+    if (variant->OffsetSize != (int)sizeof(void *))
+    {
+        Log() << "[Init] Error: the file has " << variant->OffsetSize * 8 << "-bit offsets, only files with " << sizeof(void *) * 8 << "-bit offsets can be loaded by this build!" << std::endl;
+        delete header;
+        return 1;
+    }
 
-            std::cout << "[Init] Filename: " << relatedFileName << std::endl;
+    // the counts, vertices and indices in the data are in the byte order of the file too, and the users of the data read them in the host byte order; they are not converted, so such a file is rejected instead of being read wrong (File::Scan() reads files of either byte order)
+    if (variant->BigEndian != BRES_HOST_BIG_ENDIAN)
+    {
+        Log() << "[Init] Error: the file is " << (variant->BigEndian ? "big" : "little") << "-endian, only files of the byte order of the host can be loaded!" << std::endl;
+        delete header;
+        return 1;
+    }
 
-            // load related bdae file (?)
-            // collada::CResFileManager::getInst()->get(buff, NULL, true);
-        }
-        else
-            std::cout << "[Init] Invalid name. No related files found."
-                      << std::endl;
+    file->read(rawHeader + BRES_DETECT_SIZE, headerSize - BRES_DETECT_SIZE);
+    variant->ConvertHeader(rawHeader, header);
+
+    Log() << "_________________" << std::endl;
+    Log() << "\nFile Header Data\n"
+          << std::endl;
+    Log() << "Signature: " << ((char *)&header->signature)[0] << ((char *)&header->signature)[1] << ((char *)&header->signature)[2] << ((char *)&header->signature)[3] << std::endl;
+    Log() << "Endian check: " << header->endianCheck << std::endl;
+    Log() << "Version: " << header->version << std::endl;
+    Log() << "Header size: " << header->sizeOfHeader << std::endl;
+    Log() << "File size: " << header->sizeOfFile << std::endl;
+    Log() << "Number of offsets: " << header->numOffsets << std::endl;
+    Log() << "Origin: " << header->origin << std::endl;
+    Log() << "\nSection offsets  " << std::endl;
+    Log() << "Offset Data:   " << header->offsets.m_offset << std::endl;
+    Log() << "String Data:   " << header->stringData.m_offset << std::endl;
+    Log() << "Data:          " << header->data.m_offset << std::endl;
+    Log() << "Related files: " << header->relatedFiles.m_offset << std::endl;
+    Log() << "Removable:     " << header->removable.m_offset << std::endl;
+    Log() << "\nSize of Removable Chunk: " << header->sizeOfRemovableChunk << std::endl;
+    Log() << "Number of Removable Chunks: " << header->nbOfRemovableChunks << std::endl;
+    Log() << "Use separated allocation: " << ((header->useSeparatedAllocationForRemovableBuffers > 0) ? "Yes" : "No") << std::endl;
+    Log() << "Size of Dynamic Chunk: " << header->sizeOfDynamicChunk << std::endl;
+    Log() << "________________________\n"
+          << std::endl;
+
+    // 2. Initialize File struct variables and allocate memory for reading rest of the file.
+    // the section sizes come from the header, so they are checked against the file size (in 64 bits, the header fields are unsigned) before anything is moved, copied or read with them
+    long long sizeOffsetTable64 = (long long)header->numOffsets * sizeof(Access<Access<int>>);
+    long long sizeStringTable64 = (ExtractStringTable ? (long long)header->data.m_offset - (long long)header->stringData.m_offset : 0);
+    long long sizeTables64 = sizeOffsetTable64 + sizeStringTable64;
+    long long sizeUnRemovable64 = Size - sizeTables64 - header->sizeOfRemovableChunk - header->sizeOfDynamicChunk;
+
+    if (sizeStringTable64 < 0 || headerSize + sizeTables64 > Size || sizeUnRemovable64 < headerSize || sizeUnRemovable64 > Size ||
+        (long long)header->nbOfRemovableChunks * 2 * sizeof(uint64_t) > header->sizeOfRemovableChunk)
+    {
+        Log() << "[Init] Error: the section sizes in the header do not fit in the file size, the file is damaged!" << std::endl;
+        delete header;
+        return 1;
     }
 
-    // 3. Initialize File struct variables and allocate memory for reading rest of the file.
     int sizeOffsetTable;
     int sizeStringTable;
     int sizeDynamicContent;
 
-    sizeOffsetTable = header->numOffsets * sizeof(uint64_t);
+    sizeOffsetTable = header->numOffsets * sizeof(Access<Access<int>>);
     sizeStringTable = (ExtractStringTable ? header->data.m_offset - header->stringData.m_offset : 0);
     SizeRemovableBuffer = header->sizeOfRemovableChunk;
     sizeDynamicContent = header->sizeOfDynamicChunk;
@@ -117,85 +132,225 @@ int File::Init(IReadResFile *file)
     NbRemovableBuffers = header->nbOfRemovableChunks;
     UseSeparatedAllocationForRemovableBuffers = (header->useSeparatedAllocationForRemovableBuffers > 0) ? true : false;
 
-    char *offsetBuffer = new char[sizeOffsetTable];                               // temp buffer for offset table
-    char *stringBuffer = (ExtractStringTable ? new char[sizeStringTable] : NULL); // temp buffer for string table
-    char *buffer = (char *)malloc(SizeUnRemovable);                               // main buffer
+    char *offsetBuffer;
+    char *stringBuffer;
+    char *buffer;
 
-    memcpy(buffer, header, headerSize); // copy header
+    RemovableBuffers = NULL;
+    RemovableBuffersInfo = NULL;
 
-    // 4. Read offset, string, data and related files sections as a raw binary data.
-    file->seek(headerSize);
-    std::cout << "\n[Init] At position " << file->getPos() << ", reading offset " << (sizeStringTable ? "and string tables.." : "table..") << std::endl;
+    char *source = (file->isAllInMemory() ? (char *)file->getBuffer(NULL) : NULL); // (the size returned by getBuffer() is the read position for libio memory files, so the file size is used instead)
+    bool inPlace = (source != NULL);
 
-    file->read(offsetBuffer, sizeOffsetTable);
+    if (inPlace)
+    {
+        // 3a. The source file is already in memory (e.g. an entry inflated by the archive reader), so instead of copying it section by section we fix it up directly in its buffer (the source buffer is modified, and the source file is kept alive for as long as this File uses it).
+        Log() << "\n[Init] Source file is already in memory, using its buffer in place.." << std::endl;
 
-    if (sizeStringTable)
-        file->read(stringBuffer, sizeStringTable);
+        /*
+            on disk:    [header][offset table][string table][data ... ][removable info][removable chunks]
+            in place:   [offset table][string table][header][data ... ][removable info][removable chunks]
 
-    std::cout << "\n[Init] At position " << file->getPos() << ", reading rest of the file (up to the removable section).." << std::endl;
-    file->read(&buffer[headerSize], SizeUnRemovable - headerSize); // insert after header
+            the tables are moved to the front, so that the header can be placed right before the Data section (the same layout as the main buffer in 3b)
+        */
+        int sizeTables = sizeOffsetTable + sizeStringTable;
+        memmove(source, source + headerSize, sizeTables);
 
-    // 5. Read removable chunks.
-    RemovableBuffers = NULL;
+        offsetBuffer = source;
+        stringBuffer = (ExtractStringTable ? source + sizeOffsetTable : NULL);
+        buffer = source + sizeTables;
 
-    if (SizeRemovableBuffer > 0)
-    {
-        // read size / offset pairs for each removable chunk
-        std::cout << "\n[Init] At position " << file->getPos() << ", reading removable section info.." << std::endl;
-        RemovableBuffersInfo = new uint64_t[NbRemovableBuffers * 2];
-        file->read(RemovableBuffersInfo, NbRemovableBuffers * 2 * sizeof(uint64_t));
+        memcpy(buffer, header, headerSize);
 
-        std::cout << "\n_____________________\n"
-                  << std::endl;
-        std::cout << "Removable chunks info" << std::endl;
-        std::cout << "[#] (size, offset)" << std::endl;
-        for (int i = 0; i < NbRemovableBuffers; ++i)
+        // 4a. Point to removable chunks inside the buffer.
+        if (SizeRemovableBuffer > 0)
         {
-            std::cout << "[" << i + 1 << "] " << "(" << RemovableBuffersInfo[i * 2]
-                      << ", " << RemovableBuffersInfo[i * 2 + 1] << ")"
-                      << std::endl;
+            RemovableBuffersInfo = reinterpret_cast<uint64_t *>(buffer + SizeUnRemovable);
+            char *chunk = reinterpret_cast<char *>(RemovableBuffersInfo + NbRemovableBuffers * 2);
+
+            // every chunk must lie inside the removable section of the source buffer, as the chunks are used where they are
+            uint64_t totalDataSize = SizeRemovableBuffer - (NbRemovableBuffers * 2 * sizeof(uint64_t));
+            uint64_t end = 0;
+
+            for (int i = 0; i < NbRemovableBuffers && end <= totalDataSize; ++i)
+            {
+                uint64_t chunkSize = RemovableBuffersInfo[i * 2];
+                uint64_t chunkOffset = (UseSeparatedAllocationForRemovableBuffers ? end : RemovableBuffersInfo[i * 2 + 1] - RemovableBuffersInfo[1]);
+
+                end = (chunkOffset > totalDataSize || chunkSize > totalDataSize - chunkOffset ? totalDataSize + 1 : chunkOffset + chunkSize);
+            }
+
+            if (end > totalDataSize)
+            {
+                Log() << "[Init] Error: a removable chunk lies outside of the removable section, the file is damaged!" << std::endl;
+                RemovableBuffersInfo = NULL;
+                delete header;
+                return 1;
+            }
+
+            RemovableBuffers = new void *[NbRemovableBuffers];
+
+            for (int i = 0; i < NbRemovableBuffers; ++i)
+            {
+                // separated allocation mode: chunks follow each other; single-block mode: chunk i is placed relative to the first one by its offset
+                if (UseSeparatedAllocationForRemovableBuffers)
+                {
+                    RemovableBuffers[i] = chunk;
+                    chunk += RemovableBuffersInfo[i * 2];
+                }
+                else
+                    RemovableBuffers[i] = chunk + (RemovableBuffersInfo[i * 2 + 1] - RemovableBuffersInfo[1]);
+            }
         }
-        std::cout << "________________\n"
-                  << std::endl;
 
-        // read chunks data
-        std::cout << "[Init] At position " << file->getPos() << ", reading removable section data.." << std::endl;
-        RemovableBuffers = new void *[NbRemovableBuffers];
+        file->seek(Size);
+    }
+    else
+    {
+        offsetBuffer = new char[sizeOffsetTable];                               // temp buffer for offset table
+        stringBuffer = (ExtractStringTable ? new char[sizeStringTable] : NULL); // temp buffer for string table
+        buffer = (char *)malloc(SizeUnRemovable);                               // main buffer
+
+        memcpy(buffer, header, headerSize); // copy header
+
+        // 3b. Read offset, string, data and related files sections as a raw binary data. The extent of all sections is known from the header, so the rest of the file is read ahead as one range (announced to the system for disk files, read in large windows for any other source) instead of waiting for each section in turn.
+        file->seek(headerSize);
+
+        IReadResFile *source = file;
+        file = createReadaheadReadFile(source, Size - headerSize);
+
+        Log() << "\n[Init] At position " << file->getPos() << ", reading offset " << (sizeStringTable ? "and string tables.." : "table..") << std::endl;
 
-        if (UseSeparatedAllocationForRemovableBuffers)
+        file->read(offsetBuffer, sizeOffsetTable);
+
+        if (sizeStringTable)
+            file->read(stringBuffer, sizeStringTable);
+
+        Log() << "\n[Init] At position " << file->getPos() << ", reading rest of the file (up to the removable section).." << std::endl;
+        file->read(&buffer[headerSize], SizeUnRemovable - headerSize); // insert after header
+
+        // 4b. Read removable chunks.
+        if (SizeRemovableBuffer > 0)
         {
-            // separated allocation mode: read each chunk into its own buffer
-            for (int i = 0; i < NbRemovableBuffers; ++i)
+            // read size / offset pairs for each removable chunk
+            Log() << "\n[Init] At position " << file->getPos() << ", reading removable section info.." << std::endl;
+            RemovableBuffersInfo = new uint64_t[NbRemovableBuffers * 2];
+            file->read(RemovableBuffersInfo, NbRemovableBuffers * 2 * sizeof(uint64_t));
+
+            // read chunks data
+            Log() << "[Init] At position " << file->getPos() << ", reading removable section data.." << std::endl;
+            RemovableBuffers = new void *[NbRemovableBuffers];
+
+            if (UseSeparatedAllocationForRemovableBuffers)
             {
-                uint64_t bufSize = RemovableBuffersInfo[i * 2];
-                RemovableBuffers[i] = new char[bufSize];
-                file->read(RemovableBuffers[i], bufSize);
+                // separated allocation mode: read each chunk into its own buffer
+                for (int i = 0; i < NbRemovableBuffers; ++i)
+                {
+                    uint64_t bufSize = RemovableBuffersInfo[i * 2];
+                    RemovableBuffers[i] = new char[bufSize];
+                    file->read(RemovableBuffers[i], bufSize);
+                }
+            }
+            else
+            {
+                // single-block mode: read all chunks into one large buffer
+
+                /*
+                    RemovableBuffers[0]             → pointer to the entire data block
+                    RemovableBuffers[i] (for i > 0) → pointer into that block at the start of chunk i
+                */
+                uint64_t totalDataSize = SizeRemovableBuffer - (NbRemovableBuffers * 2 * sizeof(uint64_t));
+                RemovableBuffers[0] = new char[totalDataSize];
+                file->read(RemovableBuffers[0], totalDataSize);
+
+                uint64_t baseOffset = RemovableBuffersInfo[1];
+
+                // assign pointers
+                for (int i = 1; i < NbRemovableBuffers; ++i)
+                {
+                    uint64_t chunkOffset = RemovableBuffersInfo[i * 2 + 1];
+                    RemovableBuffers[i] = (char *)RemovableBuffers[0] + (chunkOffset - baseOffset);
+                }
             }
         }
-        else
+
+        source->seek(file->getPos()); // (a positional source is read without moving its position)
+        file->drop();
+        file = source;
+    }
+
+    if (SizeRemovableBuffer > 0)
+    {
+        Log() << "\n_____________________\n"
+              << std::endl;
+        Log() << "Removable chunks info" << std::endl;
+        Log() << "[#] (size, offset)" << std::endl;
+        for (int i = 0; i < NbRemovableBuffers; ++i)
         {
-            // single-block mode: read all chunks into one large buffer
+            Log() << "[" << i + 1 << "] " << "(" << RemovableBuffersInfo[i * 2]
+                  << ", " << RemovableBuffersInfo[i * 2 + 1] << ")"
+                  << std::endl;
+        }
+        Log() << "________________\n"
+              << std::endl;
+    }
 
-            /*
-                RemovableBuffers[0]             → pointer to the entire data block
-                RemovableBuffers[i] (for i > 0) → pointer into that block at the start of chunk i
-            */
-            uint64_t totalDataSize = SizeRemovableBuffer - (NbRemovableBuffers * 2 * sizeof(uint64_t));
-            RemovableBuffers[0] = new char[totalDataSize];
-            file->read(RemovableBuffers[0], totalDataSize);
+    // 5. Search for related files. The name is taken from the loaded Data section rather than read from the source file, so the source is only ever read forward (the rest of the file is read ahead as one range, see 3b).
+    unsigned int beginOfRelatedFiles = header->relatedFiles.m_offset - header->origin;
+    File *relatedFile = NULL;
+
+    if (header->origin == 0)
+    {
+        Log() << "[Init] At position " << beginOfRelatedFiles << ", checking for related filenames.." << std::endl;
+
+        // the main buffer holds the header and everything after the offset and string tables
+        long posInBuffer = (long)beginOfRelatedFiles - sizeOffsetTable - sizeStringTable;
+
+        if (posInBuffer >= headerSize && posInBuffer + 4 <= SizeUnRemovable)
+        {
+            // read name size of the related file
+            int sizeOfName = 0;
+            memcpy(&sizeOfName, buffer + posInBuffer, 4);
+
+            // (formatted into a local stream: files are loaded in parallel, and the format flags of std::cout are shared)
+            unsigned char *bytes = reinterpret_cast<unsigned char *>(&sizeOfName);
+            std::ostringstream hexBytes;
+            for (int i = 0; i < 4; ++i)
+                hexBytes << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(bytes[i]) << " ";
 
-            uint64_t baseOffset = RemovableBuffersInfo[1];
+            Log() << "[Init] Size of related filename: " << hexBytes.str() << "(" << sizeOfName << " byte)" << std::endl;
 
-            // assign pointers
-            for (int i = 1; i < NbRemovableBuffers; ++i)
+            // validity check: name size should not exceed the limit for filename length
+            if (sizeOfName > 256)
+                Log() << "[Init] Warning: sizeOfName exceeds buffer size!" << std::endl;
+
+            // validity check: name is real (size 1 means none)
+            if (sizeOfName > 1)
             {
-                uint64_t chunkOffset = RemovableBuffersInfo[i * 2 + 1];
-                RemovableBuffers[i] = (char *)RemovableBuffers[0] + (chunkOffset - baseOffset);
+                // read name of the related file
+                char relatedFileName[256];
+                long sizeToCopy = std::min<long>(std::min(sizeOfName, 255), SizeUnRemovable - posInBuffer - 4);
+                memcpy(relatedFileName, buffer + posInBuffer + 4, sizeToCopy);
+                relatedFileName[sizeToCopy] = '\0';
+
+                Log() << "[Init] Filename: " << relatedFileName << std::endl;
+
+                // load the related file now: its data must be initialized before the external references to it are resolved in the real init below (it is shared with the other files that reference it)
+                relatedFile = CResFileManager::getInst()->get(relatedFileName, archive);
+
+                if (!relatedFile)
+                    Log() << "[Init] Warning: related file could not be loaded, external references will be NULL." << std::endl;
             }
+            else
+                Log() << "[Init] Invalid name. No related files found."
+                      << std::endl;
         }
+        else
+            Log() << "[Init] Related files section is outside of the Data section. No related files found."
+                  << std::endl;
     }
 
-    std::cout << "[Init] Stopped reading " << file->getFileName() << " at position " << file->getPos() << " (end of file)." << std::endl;
+    Log() << "[Init] Stopped reading " << file->getFileName() << " at position " << file->getPos() << " (end of file)." << std::endl;
 
     delete header;
 
@@ -205,13 +360,25 @@ int File::Init(IReadResFile *file)
                  RemovableBuffers,
                  UseSeparatedAllocationForRemovableBuffers,
                  offsetBuffer,
-                 stringBuffer);
+                 stringBuffer,
+                 relatedFile);
 
-    // causes wrong offset for the first 2 offset entries
-    delete[] offsetBuffer;
-    OffsetTable = NULL;
+    // the source file owns the in-place buffer; keep it alive until Free()
+    SourceFile = NULL;
+
+    if (inPlace)
+    {
+        SourceFile = file;
+        SourceFile->grab();
+    }
+    else
+    {
+        // causes wrong offset for the first 2 offset entries
+        delete[] offsetBuffer;
+        delete[] stringBuffer;
+    }
 
-    delete[] stringBuffer;
+    OffsetTable = NULL;
     StringTable = NULL;
 
     // delete[] RemovableBuffersInfo;
@@ -220,15 +387,196 @@ int File::Init(IReadResFile *file)
     return IsValid != 1;
 }
 
+//! Releases the memory of the loaded .bdae file sections.
+// _____________________________________________________
+
+void File::Free()
+{
+    if (SourceFile)
+    {
+        // all sections live in the buffer of the source file
+        SourceFile->drop();
+        SourceFile = NULL;
+    }
+    else
+    {
+        free(DataBuffer);
+
+        if (RemovableBuffers)
+        {
+            int nbAllocations = (UseSeparatedAllocationForRemovableBuffers ? NbRemovableBuffers : 1);
+
+            for (int i = 0; i < nbAllocations; ++i)
+                delete[] static_cast<char *>(RemovableBuffers[i]);
+        }
+
+        delete[] RemovableBuffersInfo;
+    }
+
+    delete[] RemovableBuffers;
+
+    DataBuffer = NULL;
+    RemovableBuffers = NULL;
+    RemovableBuffersInfo = NULL;
+
+    // the related file is freed when no other file uses it
+    CResFileManager::getInst()->release(RelatedFile);
+    RelatedFile = NULL;
+}
+
+//! Reads the metadata of a .bdae file for indexing: 3 small ranged reads (header, String Data section, related file name) instead of loading and fixing up the whole file.
+// _______________________________________________________________________________________________________________________________________________________________
+
+int File::Scan(IReadResFile *file, FileSummary &summary)
+{
+    summary.Subversion = NULL;
+    summary.Header = FileHeaderData();
+    summary.Strings.clear();
+    summary.RelatedFiles.clear();
+
+    long fileSize = file->getSize();
+
+    // 1. Read and convert the header. (nothing is printed on success: a scan is run over whole corpora)
+    unsigned char rawHeader[sizeof(FileHeaderLayout<uint64_t>)];
+    const BRESVariantFunctions *variant = NULL;
+
+    if (file->seek(0) && file->read(rawHeader, BRES_DETECT_SIZE) == BRES_DETECT_SIZE)
+        variant = DetectBRESVariant(rawHeader);
+
+    if (!variant)
+    {
+        Log() << "[Scan] Error: " << file->getFileName() << " is not a .bdae file." << std::endl;
+        return 1;
+    }
+
+    // (unlike Init(), files of any pointer size can be scanned: only the header layout depends on it)
+    int sizeOfHeader = (variant->OffsetSize == 8 ? sizeof(FileHeaderLayout<uint64_t>) : sizeof(FileHeaderLayout<uint32_t>));
+
+    if (file->read(rawHeader + BRES_DETECT_SIZE, sizeOfHeader - BRES_DETECT_SIZE) != sizeOfHeader - BRES_DETECT_SIZE)
+    {
+        Log() << "[Scan] Error: " << file->getFileName() << " is truncated." << std::endl;
+        return 1;
+    }
+
+    FileHeaderData &header = summary.Header;
+    variant->ConvertHeader(rawHeader, &header);
+    summary.Subversion = variant->Name;
+
+    // on-disk offsets of the sections (from the beginning of the file)
+    unsigned long beginOfStrings = header.stringData.m_offset - header.origin;
+    unsigned long endOfStrings = header.data.m_offset - header.origin;
+    unsigned long beginOfRelatedFiles = header.relatedFiles.m_offset - header.origin;
+    unsigned long beginOfRemovable = header.removable.m_offset - header.origin;
+
+    if (beginOfStrings > endOfStrings || endOfStrings > (unsigned long)fileSize)
+    {
+        Log() << "[Scan] Error: " << file->getFileName() << " has an invalid String Data section." << std::endl;
+        return 1;
+    }
+
+    // 2. Read the String Data section: a sequence of 4-byte lengths, each followed by the string, padded to 4 bytes.
+    std::vector<char> strings(endOfStrings - beginOfStrings);
+
+    if (!strings.empty() && (!file->seek(beginOfStrings) || file->read(&strings[0], strings.size()) != (int)strings.size()))
+    {
+        Log() << "[Scan] Error: " << file->getFileName() << " is truncated." << std::endl;
+        return 1;
+    }
+
+    size_t pos = 0;
+
+    while (pos + sizeof(unsigned int) <= strings.size())
+    {
+        unsigned int length;
+        memcpy(&length, &strings[pos], sizeof(length));
+        length = variant->Convert32(length);
+        pos += sizeof(length);
+
+        if (length > strings.size() - pos)
+            break;
+
+        if (length > 0)
+            summary.Strings.push_back(std::string(&strings[pos], length));
+
+        pos = (pos + length + 3) & ~(size_t)3;
+    }
+
+    // 3. Read the name of the related file (only main files have one; it is stored at the end of the Data section, before the Removable section).
+    if (header.origin == 0 && beginOfRelatedFiles >= endOfStrings && beginOfRelatedFiles + sizeof(int) <= std::min<unsigned long>(beginOfRemovable, fileSize))
+    {
+        char related[sizeof(int) + 256];
+        int sizeToRead = (int)std::min<unsigned long>(sizeof(related), std::min<unsigned long>(beginOfRemovable, fileSize) - beginOfRelatedFiles);
+
+        if (file->seek(beginOfRelatedFiles) && file->read(related, sizeToRead) == sizeToRead)
+        {
+            int sizeOfName;
+            memcpy(&sizeOfName, related, sizeof(sizeOfName));
+            sizeOfName = (int)variant->Convert32((uint32_t)sizeOfName);
+
+            // (size 1 means none; the size includes the terminating zero)
+            if (sizeOfName > 1)
+                summary.RelatedFiles.push_back(std::string(related + sizeof(int), strnlen(related + sizeof(int), std::min<int>(sizeOfName, sizeToRead - sizeof(int)))));
+        }
+    }
+
+    return 0;
+}
+
+//! Returns the pointer to the data at an on-disk offset of the initialized file (used to resolve the external references of the files that reference this one).
+// ___________________________________________________________________________________________________________________________________________________________
+
+void *File::ResolveOffset(unsigned int offset)
+{
+    FileHeaderData *header = ptr();
+
+    if (!header)
+        return NULL;
+
+    unsigned int rel = offset - header->origin; // offset from the beginning of this file
+
+    if (rel >= (unsigned int)Size)
+        return NULL;
+
+    // the tables were not moved out of the main buffer, so the whole file is laid out as on disk
+    if (OffsetTableEnd == 0)
+        return reinterpret_cast<char *>(header) + rel;
+
+    // Header section
+    if (rel < OffsetTableEnd)
+        return reinterpret_cast<char *>(header) + rel;
+
+    // String Data section: its strings were moved to StringStorage and can only be reached through this file's own offset table
+    if (rel < StringTableEnd)
+    {
+        Log() << "[Init] Warning: external reference into the string table of the related file." << std::endl;
+        return NULL;
+    }
+
+    // Removable section: find the chunk whose [start, end) contains the offset
+    if (rel > (unsigned int)SizeUnRemovable)
+    {
+        for (int i = 0; i < NbRemovableBuffers; ++i)
+        {
+            if (rel >= RemovableBuffersInfo[i * 2 + 1] && rel < RemovableBuffersInfo[i * 2 + 1] + RemovableBuffersInfo[i * 2])
+                return static_cast<char *>(RemovableBuffers[i]) + (rel - RemovableBuffersInfo[i * 2 + 1]);
+        }
+
+        return NULL;
+    }
+
+    // Data, Related Files sections (the main buffer holds them right after the header)
+    return reinterpret_cast<char *>(header) + rel - (StringTableEnd - header->sizeOfHeader);
+}
+
 //! MAIN initialization. Resolves all relative offsets in the loaded .bdae file, converting them to direct pointers while handling internal vs. external references, string data extraction, and removable chunks.
 // ______________________________________________________________________________________________________________________________________________________________________________________________________________
 
 int File::Init()
 {
-    std::cout << "\n\n\n\n---------------" << std::endl;
-    std::cout << "[Init] PART 2. \n       Resolving all relative offsets in the loaded .bdae file: convert them to direct pointers, handle internal vs. external references, string data extraction, and removable chunks." << std::endl;
-    std::cout << "---------------\n\n"
-              << std::endl;
+    Log() << "\n\n\n\n---------------" << std::endl;
+    Log() << "[Init] PART 2. \n       Resolving all relative offsets in the loaded .bdae file: convert them to direct pointers, handle internal vs. external references, string data extraction, and removable chunks." << std::endl;
+    Log() << "---------------\n\n"
+          << std::endl;
 
     // 6. Prepare for file processing: retrieve the Header struct from memory and initialize File struct variables (we replaced the File object with a new one by calling the second Init(), so this is the actual initialization).
     FileHeaderData *header = ptr();
@@ -238,7 +586,7 @@ int File::Init()
     SizeOffsetStringTables = 0;
 
     if (OffsetTable)
-        SizeOffsetStringTables += header->numOffsets * sizeof(uint64_t);
+        SizeOffsetStringTables += header->numOffsets * sizeof(Access<Access<int>>);
     if (StringTable && ExtractStringTable)
         SizeOffsetStringTables += header->data.m_offset - header->stringData.m_offset;
 
@@ -247,13 +595,11 @@ int File::Init()
     SizeUnRemovable = Size - SizeRemovableBuffer - SizeDynamic;
     NbRemovableBuffers = header->nbOfRemovableChunks;
 
-    /* save the header pointer into a different array index based on whether it's internal or external
-       (highest bit of the origin field is used as a flag):
+    /* the highest bit of the origin field tells whether this is a main or a related file:
 
-        0 → internal – referenced data is within the same .bdae file
-        1 → external – referenced data is in some related file
+        0 → main file – offsets beyond its size are external references into its related file
+        1 → related file – loaded by CResFileManager before the main file, its offsets start at 0x80000000
     */
-    ExternalFilePtr[(header->origin) >> 31] = reinterpret_cast<char *>(header);
 
     // validity check: file signature
     if (((char *)&header->signature)[0] != 'B' ||
@@ -261,7 +607,7 @@ int File::Init()
         ((char *)&header->signature)[2] != 'E' ||
         ((char *)&header->signature)[3] != 'S')
     {
-        std::cout << "[Init] Warning: wrong signature!" << std::endl;
+        Log() << "[Init] Warning: wrong signature!" << std::endl;
         return -1;
     }
 
@@ -269,23 +615,23 @@ int File::Init()
     if (header && (header->version & 0x8000) == 0)
     {
         header->version |= 0x8000; // set the high bit of the version by doing a bitwise OR with 0x8000
-        std::cout << "[Init] Passed validity checks! This file hasn't been processed yet. Proceeding with configuration.." << std::endl;
+        Log() << "[Init] Passed validity checks! This file hasn't been processed yet. Proceeding with configuration.." << std::endl;
 
         // 7a. There is a temporary, separate, deletable buffer for the offset table (allocated in the first Init()). We have to process each table entry, correcting it, retrieving string data, and then converting its contained relative offset to a direct pointer.
         if (OffsetTable)
         {
-            std::cout << "[Init] Using a temporary buffer for offset table. Retrieving the string data, applying offset correction, and performing offset-to-pointer conversion.." << std::endl;
+            Log() << "[Init] Using a temporary buffer for offset table. Retrieving the string data, applying offset correction, and performing offset-to-pointer conversion.." << std::endl;
 
             SizeOfHeader = header->sizeOfHeader;
             (&header->offsets)[0] = OffsetTable; // override the address of the offset table in the Header struct to point to the temp buffer for offset table (this allows to perform all pointer fix-ups against our own copy and safely free or reallocate it without touching the original memory block mapped from the .bdae file)
 
             // sizes and pointers of the offset / string tables
-            int sizeOffsetTable = header->numOffsets * sizeof(uint64_t);
+            int sizeOffsetTable = header->numOffsets * sizeof(Access<Access<int>>);
             int sizeStringTable = (ExtractStringTable ? header->data.m_offset - header->stringData.m_offset : 0);
             unsigned int offsetTableEnd = sizeOffsetTable + SizeOfHeader;
             unsigned int stringTableEnd = ExtractStringTable ? offsetTableEnd + sizeStringTable : offsetTableEnd;
-            ExternalFileOffsetTableSize[(header->origin) >> 31] = offsetTableEnd;
-            ExternalFileStringTableSize[(header->origin) >> 31] = stringTableEnd;
+            OffsetTableEnd = offsetTableEnd; // kept for ResolveOffset()
+            StringTableEnd = stringTableEnd;
             char *stringTableStartPtr = (char *)StringTable;
 
             // loop through each entry in the offset table
@@ -302,20 +648,24 @@ int File::Init()
                 uintptr_t offptr = reinterpret_cast<uintptr_t>(offset.ptr()) - (header->origin); // outer offset: relative offset from the file’s origin to the target pointer of this entry (had to change unsigned int to uintptr_t variable type to silence the pointer arithmetic warning)
                 unsigned int ote = offsetTableEnd;
                 unsigned int ste = stringTableEnd;
-                bool external = false; // flag to indicate if this entry refers to an external memory chunk
 
-                // if this entry’s target lies beyond the bounds of the current .bdae file, adjust values to "external mode"
+                // if this entry’s target lies beyond the bounds of the current .bdae file, it is an external reference into the related file
                 if (offptr > (unsigned int)Size)
                 {
-                    origin = ExternalFilePtr[offptr >> 31];
-                    originoff = ((offptr >> 31) << 31); // set base offset to 0x80000000
-                    offptr += header->origin;           // convert to absolute offset
-                    ote = ExternalFileOffsetTableSize[offptr >> 31];
-                    ste = ExternalFileStringTableSize[offptr >> 31];
-                    external = true; // mark that we are now resolving an external reference
+                    offptr += header->origin; // convert to absolute offset (the related file's offsets start at 0x80000000)
+
+                    void *target = (RelatedFile ? RelatedFile->ResolveOffset(offptr) : NULL);
+
+                    if (!target)
+                        Log() << "[Init] Warning: unresolved external reference [" << i + 1 << "] at offset " << offptr << std::endl;
+
+                    offset = Access<Access<int>>(target);
+
+                    // skip the second pass: the inner pointer lies in the related file, which was initialized on its own
+                    continue;
                 }
 
-                // std::cout << "[" << i + 1 << "] " << offptr << std::endl;
+                // Log() << "[" << i + 1 << "] " << offptr << std::endl;
 
                 // if this entry’s target lies after the Offset Data section
                 if (offptr >= ote)
@@ -350,7 +700,7 @@ int File::Init()
                                 nb1++;
                             }
 
-                            void *base = (char *)((char *)RemovableBuffers[nb1] - (char *)RemovableBuffersInfo[nb1 * 2 + 1]); // pointer to the beginning of the nb1-th chunk in the Removable section
+                            void *base = (char *)((char *)RemovableBuffers[nb1] - (char *)(RemovableBuffersInfo[nb1 * 2 + 1] + originoff)); // pointer to the beginning of the nb1-th chunk in the Removable section
                             offset.OffsetToPtr(base);
 
                             uintptr_t offptrptr = reinterpret_cast<uintptr_t>(offset.ptr()->ptr()) - (header->origin); // relative offset from the file’s origin to the actual data of this chunk (i.e., the inner pointer stored at the target entry, which points to data within a removable chunk)
@@ -367,7 +717,7 @@ int File::Init()
                                     nb2++;
                                 }
 
-                                void *base = (char *)((char *)RemovableBuffers[nb2] - (char *)RemovableBuffersInfo[nb2 * 2 + 1]);
+                                void *base = (char *)((char *)RemovableBuffers[nb2] - (char *)(RemovableBuffersInfo[nb2 * 2 + 1] + originoff));
                                 offset.ptr()->OffsetToPtr(base);
                                 continue;
                             }
@@ -377,7 +727,7 @@ int File::Init()
                         // computed removable buffer number was valid but no correction is desired (it is commented out in the source code)
                         else
                         {
-                            void *base = (char *)((char *)RemovableBuffers[nb] - (char *)RemovableBuffersInfo[nb * 2 + 1]);
+                            void *base = (char *)((char *)RemovableBuffers[nb] - (char *)(RemovableBuffersInfo[nb * 2 + 1] + originoff));
                             offset.OffsetToPtr(base);
                             continue;
                         }
@@ -396,10 +746,6 @@ int File::Init()
                     offset.OffsetToPtr(base);
                 }
 
-                // for external reference, we skip the rest of the loop and go to the next iteration (reference file might not be loaded yet and must be initialized independently)
-                if (external)
-                    continue;
-
                 /* SECOND PASS. Inner pointer.
                    Process offptrptr in the same way, with minor changes to the logic.
                    ─────────────────────────────────────────────────────────────────── */
@@ -412,16 +758,21 @@ int File::Init()
                     ote = offsetTableEnd;
                     ste = stringTableEnd;
 
+                    // the inner pointer lies in this file but points into the related file
                     if (offptrptr > (unsigned int)Size)
                     {
-                        origin = ExternalFilePtr[offptrptr >> 31];
-                        originoff = (offptrptr >> 31) << 31;
                         offptrptr += header->origin;
-                        ote = ExternalFileOffsetTableSize[offptrptr >> 31];
-                        ste = ExternalFileStringTableSize[offptrptr >> 31];
+
+                        void *target = (RelatedFile ? RelatedFile->ResolveOffset(offptrptr) : NULL);
+
+                        if (!target)
+                            Log() << "[Init] Warning: unresolved external reference [" << i + 1 << "] at offset " << offptrptr << std::endl;
+
+                        *static_cast<Access<int> *>(offset.ptr()) = Access<int>(target);
+                        continue;
                     }
 
-                    // std::cout << "[" << i + 1 << "] " << offptrptr << std::endl;
+                    // Log() << "[" << i + 1 << "] " << offptrptr << std::endl;
 
                     if (offptrptr >= ote)
                     {
@@ -448,7 +799,7 @@ int File::Init()
                                 nb++;
                             }
 
-                            offset.ptr()->OffsetToPtr((char *)RemovableBuffers[nb] - offptrptr + sizeof(int));
+                            offset.ptr()->OffsetToPtr((char *)RemovableBuffers[nb] - offptrptr - originoff + sizeof(int));
                         }
                         else
                             offset.ptr()->OffsetToPtr(origin - (ste - SizeOfHeader) - originoff);
@@ -463,7 +814,7 @@ int File::Init()
         /* 7b. This occurs when a temporary buffer is not used. The offset table is in-place — directly in the file’s main memory buffer — no separate deletable buffer (OffsetTable == NULL), so no need to retrieve or correct anything. Simply convert relative offsets to direct pointers. */
         else
         {
-            std::cout << "[Init] No temporary buffer found for offset table, though no retrieval or correction required. Only performing offset-to-pointer conversion.." << std::endl;
+            Log() << "[Init] No temporary buffer found for offset table, though no retrieval or correction required. Only performing offset-to-pointer conversion.." << std::endl;
 
             // if the offset table is in-place, then the string table must be as well
             if (StringTable != NULL)
@@ -485,18 +836,18 @@ int File::Init()
         }
     }
 
-    std::cout << "\n[Init] Finishing File::Init..\n\n"
-              << std::endl;
+    Log() << "\n[Init] Finishing File::Init..\n\n"
+          << std::endl;
 
-    std::cout << "_____________________" << std::endl;
-    std::cout << "\nExtracted String Data\n"
-              << std::endl;
+    Log() << "_____________________" << std::endl;
+    Log() << "\nExtracted String Data\n"
+          << std::endl;
 
     for (int i = 0; i < StringStorage.size(); ++i)
-        std::cout << "[" << std::setw(2) << i + 1 << "] \"" << StringStorage[i] << "\"" << std::endl;
+        Log() << "[" << (i < 9 ? " " : "") << i + 1 << "] \"" << StringStorage[i] << "\"" << std::endl;
 
-    std::cout << "_____________________\n"
-              << std::endl;
+    Log() << "_____________________\n"
+          << std::endl;
 
     return 0;
 }
@@ -2,10 +2,14 @@
 #define __RESFILE_H_INCLUDED__
 
 #include <string.h>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
 #include "access.h"
-#include "libs/io/CPackResReader.h"
+#include "libs/io/CIndexedPackPatchReader.h"
 
-// .bdae file header structure
+// .bdae file header structure (in-memory form; the on-disk layouts of the 4 subversions are described in bresFormat.h)
 struct FileHeaderData
 {
     unsigned int signature;                                 // 4 bytes  file signature – 'BRES' for .bdae file
@@ -26,6 +30,15 @@ struct FileHeaderData
     unsigned int sizeOfDynamicChunk;                        // 4 bytes  size of dynamic chunk (?)
 };
 
+// summary of a .bdae file returned by File::Scan(): the header and the metadata that can be read without loading the whole file
+struct FileSummary
+{
+    const char *Subversion;                // byte order and size of the offsets, e.g. "little-endian 64-bit"
+    FileHeaderData Header;                 // header converted to the host byte order (counts and sizes of all sections)
+    std::vector<std::string> Strings;      // contents of the String Data section, in file order
+    std::vector<std::string> RelatedFiles; // names of the related files
+};
+
 /*
     We end up with a fully–populated File object whose entire .bdae payload is in memory (header + offset table + string table + data + removable chunks), with every offset “fix‑up” to real C++ pointers and all embedded strings pulled out into shared‐string instances.
 */
@@ -33,7 +46,7 @@ struct FileHeaderData
 // [TODO] annotate
 struct File : public Access<FileHeaderData>
 {
-    std::vector<std::string> StringStorage;
+    std::deque<std::string> StringStorage; // extracted strings; the offset table points into them, so they must never move (a deque does not relocate its elements when it grows)
 
     int Size;
     int SizeUnRemovable;
@@ -45,21 +58,22 @@ struct File : public Access<FileHeaderData>
     bool UseSeparatedAllocationForRemovableBuffers;
     int SizeDynamic;
 
-    // bad: these static variables prevent multi-threaded loading..
-    static char *ExternalFilePtr[2];
-    static int ExternalFileOffsetTableSize[2];
-    static int ExternalFileStringTableSize[2];
-    static int SizeOfHeader;
+    static thread_local int SizeOfHeader; // (per thread: files are loaded in parallel by the cache and the batch tools)
     static bool ExtractStringTable;
+    static bool Quiet; // (set by the batch tools while their threads load files: the parser, the cache, the related files and the texture search then print nothing)
 
     bool IsValid;
     void *OffsetTable;
     void *StringTable;
     void *DataBuffer;
+    IReadResFile *SourceFile; // in-memory source file whose buffer holds the sections (NULL if they were copied into own buffers)
+    File *RelatedFile;        // related file that the external references point into, loaded by CResFileManager (NULL if there is none)
+    unsigned int OffsetTableEnd; // on-disk offsets of the ends of the offset and string tables (0 if the tables were not moved out of the main buffer)
+    unsigned int StringTableEnd;
 
-    File() : IsValid(false), OffsetTable(NULL) {}
+    File() : RemovableBuffers(NULL), RemovableBuffersInfo(NULL), IsValid(false), OffsetTable(NULL), StringTable(NULL), DataBuffer(NULL), SourceFile(NULL), RelatedFile(NULL), OffsetTableEnd(0), StringTableEnd(0) {}
 
-    File(void *ptr, uint64_t *removableBuffersInfo = 0, void **removableBuffers = 0, bool useSeparatedAllocationForRemovableBuffers = false, void *offsetTable = NULL, void *stringTable = NULL)
+    File(void *ptr, uint64_t *removableBuffersInfo = 0, void **removableBuffers = 0, bool useSeparatedAllocationForRemovableBuffers = false, void *offsetTable = NULL, void *stringTable = NULL, File *relatedFile = NULL)
         : Access<FileHeaderData>(ptr),
           DataBuffer(ptr),
           IsValid(false),
@@ -67,7 +81,11 @@ struct File : public Access<FileHeaderData>
           StringTable(stringTable),
           RemovableBuffersInfo(removableBuffersInfo),
           RemovableBuffers(removableBuffers),
-          UseSeparatedAllocationForRemovableBuffers(useSeparatedAllocationForRemovableBuffers)
+          UseSeparatedAllocationForRemovableBuffers(useSeparatedAllocationForRemovableBuffers),
+          SourceFile(NULL),
+          RelatedFile(relatedFile),
+          OffsetTableEnd(0),
+          StringTableEnd(0)
     {
         if (ptr)
             IsValid = (Init() == 0);
@@ -75,7 +93,19 @@ struct File : public Access<FileHeaderData>
 
     int Init();
 
-    int Init(IReadResFile *file);
+    // archive: archive the file was opened from (may be NULL), searched first for its related file
+    int Init(IReadResFile *file, CIndexedPackPatchReader *archive = NULL);
+
+    void Free();
+
+    // log of the parser and of the loaders around it: std::cout, or a stream that discards everything while Quiet is set
+    static std::ostream &Log();
+
+    // reads only the header, the String Data section and the related file name of a .bdae file (no offset fix-up, no Data or Removable sections); returns 0 on success
+    static int Scan(IReadResFile *file, FileSummary &summary);
+
+    // returns the pointer to the data at an on-disk offset of this (initialized) file, or NULL if the offset is outside of the file or points into the extracted string table
+    void *ResolveOffset(unsigned int offset);
 };
 
 #endif
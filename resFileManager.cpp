@@ -0,0 +1,244 @@
+#include <iostream>
+#include <algorithm>
+#include "resFileManager.h"
+
+CResFileManager *CResFileManager::getInst()
+{
+    static CResFileManager instance;
+    return &instance;
+}
+
+CResFileManager::CResFileManager()
+{
+    pthread_mutex_init(&Mutex, NULL);
+    pthread_cond_init(&LoadedCondition, NULL);
+}
+
+CResFileManager::~CResFileManager()
+{
+    for (size_t i = 0; i < Archives.size(); ++i)
+        Archives[i]->drop();
+
+    pthread_cond_destroy(&LoadedCondition);
+    pthread_mutex_destroy(&Mutex);
+}
+
+void CResFileManager::addArchive(CIndexedPackPatchReader *archive)
+{
+    if (!archive)
+        return;
+
+    pthread_mutex_lock(&Mutex);
+
+    if (std::find(Archives.begin(), Archives.end(), archive) == Archives.end())
+    {
+        archive->grab();
+        Archives.push_back(archive);
+    }
+
+    pthread_mutex_unlock(&Mutex);
+}
+
+void CResFileManager::removeArchive(CIndexedPackPatchReader *archive)
+{
+    pthread_mutex_lock(&Mutex);
+
+    std::vector<CIndexedPackPatchReader *>::iterator it = std::find(Archives.begin(), Archives.end(), archive);
+    bool found = (it != Archives.end());
+
+    if (found)
+        Archives.erase(it);
+
+    pthread_mutex_unlock(&Mutex);
+
+    // (outside of the lock: the last drop deletes the archive)
+    if (found)
+        archive->drop();
+}
+
+void CResFileManager::addSearchPath(const char *path)
+{
+    if (!path)
+        return;
+
+    std::string dir(path);
+
+    if (!dir.empty() && dir[dir.size() - 1] != '/' && dir[dir.size() - 1] != '\\')
+        dir += '/';
+
+    pthread_mutex_lock(&Mutex);
+
+    if (std::find(SearchPaths.begin(), SearchPaths.end(), dir) == SearchPaths.end())
+        SearchPaths.push_back(dir);
+
+    pthread_mutex_unlock(&Mutex);
+}
+
+std::string CResFileManager::normalize(const char *name)
+{
+    std::string key(name);
+
+    for (size_t i = 0; i < key.size(); ++i)
+    {
+        if (key[i] == '\\')
+            key[i] = '/';
+        else
+            key[i] = tolower(key[i]);
+    }
+
+    return key;
+}
+
+IReadResFile *CResFileManager::open(const char *name, CIndexedPackPatchReader *archive)
+{
+    if (archive)
+        return archive->openFileView(name);
+
+    // the lists are copied, so that no lock is held while the archives and the disk are read; the archives are grabbed, so that an archive removed meanwhile is not deleted while it is read
+    pthread_mutex_lock(&Mutex);
+    std::vector<CIndexedPackPatchReader *> archives(Archives);
+    std::vector<std::string> searchPaths(SearchPaths);
+
+    for (size_t i = 0; i < archives.size(); ++i)
+        archives[i]->grab();
+
+    pthread_mutex_unlock(&Mutex);
+
+    IReadResFile *file = NULL;
+
+    for (size_t i = 0; i < archives.size() && !file; ++i)
+        file = archives[i]->openFileView(name);
+
+    for (size_t i = 0; i < archives.size(); ++i)
+        archives[i]->drop();
+
+    if (file)
+        return file;
+
+    for (size_t i = 0; i < searchPaths.size(); ++i)
+    {
+        file = createMappedReadFile((searchPaths[i] + name).c_str());
+
+        if (file)
+            return file;
+    }
+
+    return NULL;
+}
+
+File *CResFileManager::get(const char *name, CIndexedPackPatchReader *archive)
+{
+    if (!name || !name[0])
+        return NULL;
+
+    std::string key = normalize(name);
+
+    // a file of the archive of the referencing file is keyed by the archive too
+    if (archive && archive->findFile(name) >= 0)
+    {
+        const char *archiveName = archive->getPackFileName();
+        key = normalize(archiveName ? archiveName : "") + '|' + key;
+    }
+    else
+        archive = NULL;
+
+    pthread_mutex_lock(&Mutex);
+
+    // 1. Return the file if it is loaded, or wait for it if another thread is loading it.
+    std::map<std::string, Entry>::iterator it;
+
+    while ((it = Files.find(key)) != Files.end())
+    {
+        Entry &entry = it->second;
+
+        if (entry.LoadedFile)
+        {
+            entry.RefCount++;
+            pthread_mutex_unlock(&Mutex);
+            return entry.LoadedFile;
+        }
+
+        // if the other thread fails to load it, the entry is gone and this thread tries itself
+        pthread_cond_wait(&LoadedCondition, &Mutex);
+    }
+
+    // 2. Mark the file as loading, so that it is loaded only once.
+    Entry entry;
+    entry.LoadedFile = NULL;
+    entry.RefCount = 1;
+    Files[key] = entry;
+
+    pthread_mutex_unlock(&Mutex);
+
+    // 3. Load the file without holding the lock.
+    File::Log() << "\n[CResFileManager] Loading related file " << name << ".." << std::endl;
+
+    File *file = NULL;
+    IReadResFile *source = open(name, archive);
+
+    if (source)
+    {
+        file = new File;
+
+        if (file->Init(source, archive) != 0)
+        {
+            File::Log() << "[CResFileManager] Error: related file " << name << " could not be initialized." << std::endl;
+            file->Free();
+            delete file;
+            file = NULL;
+        }
+
+        source->drop();
+    }
+    else
+        File::Log() << "[CResFileManager] Warning: related file " << name << " not found." << std::endl;
+
+    // 4. Publish the result and wake up the threads waiting for it.
+    pthread_mutex_lock(&Mutex);
+
+    if (file)
+    {
+        Files[key].LoadedFile = file;
+        Keys[file] = key;
+    }
+    else
+        Files.erase(key);
+
+    pthread_cond_broadcast(&LoadedCondition);
+    pthread_mutex_unlock(&Mutex);
+
+    return file;
+}
+
+void CResFileManager::release(File *file)
+{
+    if (!file)
+        return;
+
+    pthread_mutex_lock(&Mutex);
+
+    std::map<File *, std::string>::iterator key = Keys.find(file);
+
+    if (key != Keys.end() && --Files[key->second].RefCount == 0)
+    {
+        Files.erase(key->second);
+        Keys.erase(key);
+        pthread_mutex_unlock(&Mutex);
+
+        file->Free();
+        delete file;
+        return;
+    }
+
+    pthread_mutex_unlock(&Mutex);
+}
+
+int CResFileManager::getLoadedCount()
+{
+    pthread_mutex_lock(&Mutex);
+
+    int count = (int)Keys.size();
+
+    pthread_mutex_unlock(&Mutex);
+    return count;
+}
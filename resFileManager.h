@@ -0,0 +1,68 @@
+#ifndef __RESFILEMANAGER_H_INCLUDED__
+#define __RESFILEMANAGER_H_INCLUDED__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include "resFile.h"
+#include "libs/io/CIndexedPackPatchReader.h"
+
+/*
+    Loads .bdae files that are referenced by other .bdae files (related files, e.g. shared data of many models), so that the external references of a file can be resolved to pointers into its related file.
+    Each related file is loaded once and shared by all files that reference it; it is freed when the last of them is freed.
+    A related file is based at 0x80000000 and has no related file of its own (File::Init reads the related file name only for files based at 0), so loads never nest and a thread never waits for a file that waits for it.
+    ______________________________________________________________________________________________________________________________
+*/
+
+class CResFileManager
+{
+public:
+    static CResFileManager *getInst();
+
+    // adds an archive that is searched for related files (archives are searched in the order they were added, before the search paths); it is grabbed until it is removed
+    void addArchive(CIndexedPackPatchReader *archive);
+
+    // removes an archive; lookups that are still reading it keep it alive until they are done, so the caller may drop() it right away
+    void removeArchive(CIndexedPackPatchReader *archive);
+
+    // adds a directory that is searched for related files
+    void addSearchPath(const char *path);
+
+    // returns the initialized file with the given name, loading it (and its own related file) if it isn't loaded yet; every successful call must be followed by a call to release()
+    // archive: archive of the file that references it (may be NULL), searched first; a file found there is shared only by the files of that archive, as another archive may hold a different file of the same name (the caller keeps the archive alive during the call)
+    File *get(const char *name, CIndexedPackPatchReader *archive = NULL);
+
+    // releases a file returned by get(); the file is freed when it is released by all its users
+    void release(File *file);
+
+    // number of loaded files
+    int getLoadedCount();
+
+private:
+    struct Entry
+    {
+        File *LoadedFile;   // NULL while the file is loading
+        int RefCount;
+    };
+
+    CResFileManager();
+
+    ~CResFileManager();
+
+    // opens the file from the given archive, or else from the registered archives or the search paths
+    IReadResFile *open(const char *name, CIndexedPackPatchReader *archive);
+
+    // file names are compared in lower case, with '/' as separator
+    static std::string normalize(const char *name);
+
+    std::vector<CIndexedPackPatchReader *> Archives;
+    std::vector<std::string> SearchPaths;
+    std::map<std::string, Entry> Files;
+    std::map<File *, std::string> Keys; // key of each loaded file in Files
+
+    pthread_mutex_t Mutex;
+    pthread_cond_t LoadedCondition; // signaled when a file is done loading
+};
+
+#endif
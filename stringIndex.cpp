@@ -0,0 +1,364 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <pthread.h>
+#include "stringIndex.h"
+#include "fileCache.h"
+#include "modelView.h"
+
+// state shared by the indexing threads
+struct IndexJob
+{
+    const std::vector<std::string> *Paths;
+    std::vector<std::vector<std::string>> Strings; // unique strings of each model
+    std::vector<char> Loaded;                      // whether each model could be parsed
+    std::atomic<size_t> Next;                      // next model to parse
+};
+
+static void *IndexThread(void *arg)
+{
+    IndexJob *job = static_cast<IndexJob *>(arg);
+
+    for (size_t i = job->Next++; i < job->Paths->size(); i = job->Next++)
+    {
+        const char *path = (*job->Paths)[i].c_str();
+
+        // the same variants as the viewer: the float one, or the quantized one if the archive has no float variant
+        CCachedFile *cachedFile = CFileCache::getInst()->get(path, "little_endian_not_quantized.bdae");
+
+        if (!cachedFile)
+            cachedFile = CFileCache::getInst()->get(path, "little_endian_quantized.bdae");
+
+        if (!cachedFile)
+            continue;
+
+        // a model whose mesh tables do not fit in its data is not indexed, as the viewer and the exporter skip it
+        if (!ModelView(cachedFile->getFile()).IsValid())
+        {
+            cachedFile->drop();
+            continue;
+        }
+
+        const std::deque<std::string> &storage = cachedFile->getFile().StringStorage;
+        std::vector<std::string> &strings = job->Strings[i];
+
+        strings.assign(storage.begin(), storage.end());
+        std::sort(strings.begin(), strings.end());
+        strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+
+        job->Loaded[i] = 1;
+        cachedFile->drop();
+    }
+
+    return NULL;
+}
+
+//! Builds the index of the strings of all .bdae models under a directory.
+// ______________________________________________________________________
+
+int BuildStringIndex(const char *modelDirectory, const char *indexPath, int threadCount)
+{
+    namespace fs = std::filesystem;
+
+    // 1. Collect the models (sorted, so that the model IDs don't depend on the order of the directory listing).
+    std::vector<std::string> paths;
+    std::error_code error;
+
+    for (fs::recursive_directory_iterator it(modelDirectory, fs::directory_options::skip_permission_denied, error), end; !error && it != end; it.increment(error))
+    {
+        std::string extension = it->path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+        if (it->is_regular_file() && extension == ".bdae")
+            paths.push_back(it->path().string());
+    }
+
+    if (error)
+    {
+        std::cerr << "[Index] Error: can't list " << modelDirectory << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    std::sort(paths.begin(), paths.end());
+
+    // 2. Parse the models in parallel and keep their strings. (the files themselves are not kept, and the log of the parser is turned off while the threads run)
+    // Each model is loaded by one thread, with its own archive reader that no other thread sees (the readers of the prebuilt libio are not thread safe, see ResReferenceCounted.h); the paths are unique, so no archive is opened by two threads at once.
+    IndexJob job;
+    job.Paths = &paths;
+    job.Strings.resize(paths.size());
+    job.Loaded.resize(paths.size(), 0);
+    job.Next = 0;
+
+    long budget = CFileCache::getInst()->getBudget();
+    CFileCache::getInst()->setBudget(0);
+    File::Quiet = true;
+
+    threadCount = std::max(1, std::min<int>(threadCount, (int)paths.size()));
+    std::vector<pthread_t> threads;
+
+    for (int i = 1; i < threadCount; ++i)
+    {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, IndexThread, &job) == 0)
+            threads.push_back(thread);
+    }
+
+    IndexThread(&job); // (the calling thread is one of the workers)
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+
+    File::Quiet = false;
+    CFileCache::getInst()->clear();
+    CFileCache::getInst()->setBudget(budget);
+
+    // 3. Invert: model IDs of each string. The models are visited in ID order, so each posting list is sorted.
+    std::vector<std::string> models;
+    std::map<std::string, std::vector<unsigned int>> postings;
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (!job.Loaded[i])
+        {
+            std::cerr << "[Index] Warning: " << paths[i] << " could not be parsed, skipped." << std::endl;
+            continue;
+        }
+
+        unsigned int model = (unsigned int)models.size();
+        models.push_back(fs::path(paths[i]).lexically_relative(modelDirectory).generic_string());
+
+        for (size_t j = 0; j < job.Strings[i].size(); ++j)
+            postings[job.Strings[i][j]].push_back(model);
+
+        std::vector<std::string>().swap(job.Strings[i]);
+    }
+
+    // 4. Lay out the index file.
+    std::vector<char> names, texts;
+    std::vector<StringIndexName> modelTable(models.size());
+    std::vector<StringIndexString> stringTable;
+    std::vector<unsigned int> modelIds;
+
+    stringTable.reserve(postings.size());
+
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        modelTable[i].TextOffset = (unsigned int)names.size();
+        modelTable[i].TextLength = (unsigned int)models[i].size();
+        names.insert(names.end(), models[i].begin(), models[i].end());
+    }
+
+    for (std::map<std::string, std::vector<unsigned int>>::const_iterator it = postings.begin(); it != postings.end(); ++it)
+    {
+        StringIndexString entry;
+        entry.Text.TextOffset = (unsigned int)texts.size();
+        entry.Text.TextLength = (unsigned int)it->first.size();
+        entry.FirstPosting = (unsigned int)modelIds.size();
+        entry.PostingCount = (unsigned int)it->second.size();
+        stringTable.push_back(entry);
+
+        texts.insert(texts.end(), it->first.begin(), it->first.end());
+        modelIds.insert(modelIds.end(), it->second.begin(), it->second.end());
+    }
+
+    // the tables are 4-byte aligned (the text blobs are padded)
+    names.resize((names.size() + 3) & ~(size_t)3);
+    texts.resize((texts.size() + 3) & ~(size_t)3);
+
+    StringIndexHeader header;
+    header.Magic = STRING_INDEX_MAGIC;
+    header.Version = STRING_INDEX_VERSION;
+    header.ModelCount = (unsigned int)models.size();
+    header.StringCount = (unsigned int)stringTable.size();
+
+    size_t namesOffset = sizeof(header);
+    size_t modelTableOffset = namesOffset + names.size();
+    size_t textsOffset = modelTableOffset + modelTable.size() * sizeof(StringIndexName);
+    size_t stringTableOffset = textsOffset + texts.size();
+    size_t postingOffset = stringTableOffset + stringTable.size() * sizeof(StringIndexString);
+    size_t size = postingOffset + modelIds.size() * sizeof(unsigned int);
+
+    if (size > 0xFFFFFFFFu)
+    {
+        std::cerr << "[Index] Error: the index would exceed 4 GB." << std::endl;
+        return 1;
+    }
+
+    // the text offsets are stored from the beginning of the file
+    for (size_t i = 0; i < modelTable.size(); ++i)
+        modelTable[i].TextOffset += (unsigned int)namesOffset;
+
+    for (size_t i = 0; i < stringTable.size(); ++i)
+        stringTable[i].Text.TextOffset += (unsigned int)textsOffset;
+
+    header.Size = (unsigned int)size;
+    header.ModelTableOffset = (unsigned int)modelTableOffset;
+    header.StringTableOffset = (unsigned int)stringTableOffset;
+    header.PostingOffset = (unsigned int)postingOffset;
+
+    // 5. Write it.
+    FILE *out = fopen(indexPath, "wb");
+
+    if (!out)
+    {
+        std::cerr << "[Index] Error: can't create " << indexPath << std::endl;
+        return 1;
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, out) == 1;
+    written = written && (names.empty() || fwrite(&names[0], names.size(), 1, out) == 1);
+    written = written && (modelTable.empty() || fwrite(&modelTable[0], modelTable.size() * sizeof(StringIndexName), 1, out) == 1);
+    written = written && (texts.empty() || fwrite(&texts[0], texts.size(), 1, out) == 1);
+    written = written && (stringTable.empty() || fwrite(&stringTable[0], stringTable.size() * sizeof(StringIndexString), 1, out) == 1);
+    written = written && (modelIds.empty() || fwrite(&modelIds[0], modelIds.size() * sizeof(unsigned int), 1, out) == 1);
+    written = (fclose(out) == 0) && written;
+
+    if (!written)
+    {
+        std::cerr << "[Index] Error: can't write " << indexPath << std::endl;
+        remove(indexPath);
+        return 1;
+    }
+
+    std::cout << "[Index] Indexed " << header.StringCount << " strings of " << header.ModelCount << " models (" << paths.size() - models.size() << " skipped) into " << indexPath << " (" << size << " bytes)." << std::endl;
+    return 0;
+}
+
+//! Memory-mapped index.
+// ____________________
+
+bool CStringIndex::open(const char *indexPath)
+{
+    close();
+
+    File = createMappedReadFile(indexPath);
+
+    if (!File)
+        return false;
+
+    long size = File->getSize();
+    Base = static_cast<const char *>(File->getBuffer(NULL));
+    Header = reinterpret_cast<const StringIndexHeader *>(Base);
+
+    // validity check: the tables must lie inside the file
+    bool valid = Base && size >= (long)sizeof(StringIndexHeader) &&
+                 Header->Magic == STRING_INDEX_MAGIC && Header->Version == STRING_INDEX_VERSION && Header->Size == (unsigned long)size &&
+                 Header->ModelTableOffset + (unsigned long)Header->ModelCount * sizeof(StringIndexName) <= Header->Size &&
+                 Header->StringTableOffset + (unsigned long)Header->StringCount * sizeof(StringIndexString) <= Header->Size &&
+                 Header->PostingOffset <= Header->Size;
+
+    // ..and so must the texts of the models and strings (they are compared in place by the searches)
+    for (unsigned int i = 0; valid && i < Header->ModelCount; ++i)
+        valid = textFits(reinterpret_cast<const StringIndexName *>(Base + Header->ModelTableOffset)[i]);
+
+    for (unsigned int i = 0; valid && i < Header->StringCount; ++i)
+        valid = textFits(reinterpret_cast<const StringIndexString *>(Base + Header->StringTableOffset)[i].Text);
+
+    if (!valid)
+    {
+        std::cerr << "[Index] Error: " << indexPath << " is not a valid string index." << std::endl;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void CStringIndex::close()
+{
+    if (File)
+        File->drop();
+
+    File = NULL;
+    Header = NULL;
+    Base = NULL;
+}
+
+bool CStringIndex::textFits(const StringIndexName &name) const
+{
+    return (unsigned long)name.TextOffset + name.TextLength <= Header->Size;
+}
+
+std::string CStringIndex::getText(const StringIndexName &name) const
+{
+    return std::string(Base + name.TextOffset, name.TextLength);
+}
+
+std::string CStringIndex::getModelName(unsigned int model) const
+{
+    if (!Header || model >= Header->ModelCount)
+        return std::string();
+
+    return getText(reinterpret_cast<const StringIndexName *>(Base + Header->ModelTableOffset)[model]);
+}
+
+unsigned int CStringIndex::lowerBound(const std::string &text) const
+{
+    const StringIndexString *strings = reinterpret_cast<const StringIndexString *>(Base + Header->StringTableOffset);
+    unsigned int first = 0;
+    unsigned int count = Header->StringCount;
+
+    while (count > 0)
+    {
+        unsigned int half = count / 2;
+        const StringIndexName &name = strings[first + half].Text;
+
+        // byte-wise comparison of the mapped text, without copying it
+        int cmp = memcmp(Base + name.TextOffset, text.data(), std::min<size_t>(name.TextLength, text.size()));
+
+        if (cmp < 0 || (cmp == 0 && name.TextLength < text.size()))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+            count = half;
+    }
+
+    return first;
+}
+
+void CStringIndex::find(const std::string &query, std::vector<unsigned int> &models) const
+{
+    models.clear();
+
+    if (!Header)
+        return;
+
+    const StringIndexString *strings = reinterpret_cast<const StringIndexString *>(Base + Header->StringTableOffset);
+    const unsigned int *postings = reinterpret_cast<const unsigned int *>(Base + Header->PostingOffset);
+    unsigned int postingCount = (Header->Size - Header->PostingOffset) / sizeof(unsigned int);
+
+    bool prefix = (!query.empty() && query[query.size() - 1] == '*');
+    std::string text = (prefix ? query.substr(0, query.size() - 1) : query);
+
+    // matching strings are adjacent in the sorted string table
+    for (unsigned int i = lowerBound(text); i < Header->StringCount; ++i)
+    {
+        const StringIndexString &entry = strings[i];
+
+        if (entry.Text.TextLength < text.size() || memcmp(Base + entry.Text.TextOffset, text.data(), text.size()) != 0)
+            break;
+
+        if (!prefix && entry.Text.TextLength != text.size())
+            break;
+
+        if (entry.FirstPosting <= postingCount && entry.PostingCount <= postingCount - entry.FirstPosting)
+            models.insert(models.end(), postings + entry.FirstPosting, postings + entry.FirstPosting + entry.PostingCount);
+
+        if (!prefix)
+            break;
+    }
+
+    // the posting lists of several strings overlap
+    if (prefix)
+    {
+        std::sort(models.begin(), models.end());
+        models.erase(std::unique(models.begin(), models.end()), models.end());
+    }
+}
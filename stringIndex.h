@@ -0,0 +1,90 @@
+#ifndef __STRINGINDEX_H_INCLUDED__
+#define __STRINGINDEX_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include "libs/io/IReadResFile.h"
+
+/*
+    Inverted index over the strings of a tree of .bdae models (texture names, bones, materials, shader parameters..), answering "which models use this string" without parsing any model.
+    The strings of every model are extracted by the parser (File::Init) in parallel, and the index is stored as one file that is memory-mapped as it is: a query is a binary search over the sorted strings followed by a read of the posting list (the sorted IDs of the models that use the string).
+
+    index file:   [StringIndexHeader][model names][model table][string texts][string table][postings]
+    ________________________________________________________________________________________________________________________________________
+*/
+
+#define STRING_INDEX_MAGIC 0x58444953 // 'SIDX'
+#define STRING_INDEX_VERSION 1
+
+// all offsets are in bytes from the beginning of the index file, all values are stored in the byte order of the host that built the index
+struct StringIndexHeader
+{
+    unsigned int Magic;
+    unsigned int Version;
+    unsigned int Size;              // size of the index file
+    unsigned int ModelCount;
+    unsigned int StringCount;
+    unsigned int ModelTableOffset;  // ModelCount x StringIndexName: paths of the models, relative to the indexed directory
+    unsigned int StringTableOffset; // StringCount x StringIndexString, sorted by text (byte-wise)
+    unsigned int PostingOffset;     // model IDs (unsigned int) of all posting lists
+};
+
+struct StringIndexName
+{
+    unsigned int TextOffset;
+    unsigned int TextLength;
+};
+
+struct StringIndexString
+{
+    StringIndexName Text;
+    unsigned int FirstPosting; // index of the first model ID of the posting list (from PostingOffset)
+    unsigned int PostingCount; // number of models using the string
+};
+
+// extracts the strings of every .bdae model under the directory with threadCount threads, and writes the index file; returns 0 on success
+int BuildStringIndex(const char *modelDirectory, const char *indexPath, int threadCount);
+
+/*
+    Read-only view of a memory-mapped index file.
+*/
+
+class CStringIndex
+{
+public:
+    CStringIndex() : File(NULL), Header(NULL) {}
+
+    ~CStringIndex() { close(); }
+
+    // maps the index file; returns false if it can't be opened or isn't a valid index
+    bool open(const char *indexPath);
+
+    void close();
+
+    unsigned int getModelCount() const { return Header ? Header->ModelCount : 0; }
+
+    unsigned int getStringCount() const { return Header ? Header->StringCount : 0; }
+
+    std::string getModelName(unsigned int model) const;
+
+    // returns the IDs of the models that use the string (a string ending with '*' matches every string with that prefix); the IDs are sorted and unique
+    void find(const std::string &query, std::vector<unsigned int> &models) const;
+
+private:
+    CStringIndex(const CStringIndex &);
+    CStringIndex &operator=(const CStringIndex &);
+
+    // true if the text lies inside the index file (checked for all entries by open())
+    bool textFits(const StringIndexName &name) const;
+
+    std::string getText(const StringIndexName &name) const;
+
+    // index of the first string not less than the text (in the byte-wise order of the string table)
+    unsigned int lowerBound(const std::string &text) const;
+
+    IReadResFile *File; // mapped index file
+    const StringIndexHeader *Header;
+    const char *Base;
+};
+
+#endif
@@ -0,0 +1,283 @@
+/*
+    Test of the directory export to .glb (ExportDirectoryToGLB): a model with the float variant must be exported with its vertex chunks stored as they are and a primitive per submesh, while a model with only the quantized variant is skipped (not counted as failed) and a damaged model fails.
+    The models are zip files written by the test, holding a synthetic little-endian 64-bit .bdae file laid out as the viewer expects (Data section with the mesh table and mesh metadata, one vertex chunk per mesh and one index chunk per submesh in the removable section).
+    ____________________________________________________________________________________________________________________________________________
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "../gltfExport.h"
+
+#define TEST_DIRECTORY "gltfExportTest"
+#define STRIDE 48 // bytes per vertex of the float variant (8 floats followed by attributes the exporter does not use)
+
+static int failures = 0;
+
+#define CHECK(condition, ...)                \
+    do                                       \
+    {                                        \
+        if (!(condition))                    \
+        {                                    \
+            printf("FAILED: " __VA_ARGS__);  \
+            printf("\n");                    \
+            failures++;                      \
+        }                                    \
+    } while (0)
+
+static void put16(std::string &out, unsigned int value)
+{
+    out.push_back((char)(value & 0xff));
+    out.push_back((char)(value >> 8 & 0xff));
+}
+
+static void put32(std::string &out, unsigned int value)
+{
+    put16(out, value & 0xffff);
+    put16(out, value >> 16);
+}
+
+static void put64(std::string &out, unsigned long long value)
+{
+    put32(out, (unsigned int)value);
+    put32(out, (unsigned int)(value >> 32));
+}
+
+static void set32(std::string &out, size_t pos, unsigned int value)
+{
+    std::string bytes;
+    put32(bytes, value);
+    out.replace(pos, 4, bytes);
+}
+
+// writes a zip file with one stored entry
+static bool writeZip(const std::string &fileName, const std::string &name, const std::string &data)
+{
+    std::string header, zip, directory;
+    put16(header, 20);                   // version needed
+    put16(header, 0);                    // flags
+    put16(header, 0);                    // stored
+    put32(header, 0);                    // time and date
+    put32(header, crc32(0, (const Bytef *)data.data(), data.size()));
+    put32(header, data.size());
+    put32(header, data.size());
+    put16(header, name.size());
+    put16(header, 0);                    // extra field length
+
+    put32(zip, 0x04034b50);
+    zip += header + name + data;
+
+    put32(directory, 0x02014b50);
+    put16(directory, 20);                // version made by
+    directory += header;
+    put16(directory, 0);                 // comment length
+    put16(directory, 0);                 // disk
+    put16(directory, 0);                 // internal attributes
+    put32(directory, 0);                 // external attributes
+    put32(directory, 0);                 // offset of the local header
+    directory += name;
+
+    unsigned int directoryOffset = zip.size();
+    zip += directory;
+    put32(zip, 0x06054b50);
+    put16(zip, 0);
+    put16(zip, 0);
+    put16(zip, 1);
+    put16(zip, 1);
+    put32(zip, directory.size());
+    put32(zip, directoryOffset);
+    put16(zip, 0);
+
+    std::ofstream file(fileName, std::ios::binary);
+    file.write(zip.data(), zip.size());
+    return file.good();
+}
+
+struct TestMesh
+{
+    std::string Vertices;                // vertex chunk (without its 4-byte prefix)
+    std::vector<std::string> Submeshes;  // index chunks (without their 4-byte prefix)
+};
+
+// vertex grid of n x n vertices in the xz plane, with two triangles per cell split into two submeshes
+static TestMesh makeGrid(int n, float x0)
+{
+    TestMesh mesh;
+
+    for (int x = 0; x < n; x++)
+    {
+        for (int z = 0; z < n; z++)
+        {
+            float vertex[STRIDE / 4] = {x0 + x, (float)(x * z % 5), (float)z, 0.0f, 1.0f, 0.0f, x / (n - 1.0f), z / (n - 1.0f)};
+            mesh.Vertices.append(reinterpret_cast<const char *>(vertex), STRIDE);
+        }
+    }
+
+    std::string triangles;
+
+    for (int x = 0; x < n - 1; x++)
+    {
+        for (int z = 0; z < n - 1; z++)
+        {
+            unsigned short cell[6] = {(unsigned short)(x * n + z), (unsigned short)((x + 1) * n + z), (unsigned short)(x * n + z + 1),
+                                      (unsigned short)((x + 1) * n + z), (unsigned short)((x + 1) * n + z + 1), (unsigned short)(x * n + z + 1)};
+            triangles.append(reinterpret_cast<const char *>(cell), sizeof(cell));
+        }
+    }
+
+    size_t half = triangles.size() / 12 / 2 * 6; // first half of the triangles, in bytes
+    mesh.Submeshes.push_back(triangles.substr(0, half));
+    mesh.Submeshes.push_back(triangles.substr(half));
+    return mesh;
+}
+
+// builds a .bdae file (float variant) with the meshes
+static std::string makeModel(const std::vector<TestMesh> &meshes)
+{
+    const unsigned int headerSize = 80, entryTable = 128, entrySize = 24, metadataSize = 96;
+    unsigned int offsetTable = headerSize;
+    unsigned int dataBegin = offsetTable + 8; // one offset table entry, no strings
+    unsigned int metadataTable = entryTable + entrySize * meshes.size();
+    unsigned int relatedFiles = metadataTable + metadataSize * meshes.size();
+
+    // Data section: texture count at 96, mesh count and table at 120, a mesh entry pointing to its metadata, and an empty related file name
+    std::string data(relatedFiles + 8, '\0');
+    set32(data, 120, meshes.size());
+    set32(data, 124, entryTable - 124);
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        unsigned int field = entryTable + entrySize * i + 20;
+        unsigned int metadata = metadataTable + metadataSize * i;
+        set32(data, field, metadata - field);
+        set32(data, metadata + 4, meshes[i].Vertices.size() / STRIDE);
+        set32(data, metadata + 12, meshes[i].Submeshes.size());
+    }
+
+    set32(data, relatedFiles, 1);
+
+    // removable chunks: the vertex chunk of each mesh followed by the index chunks of its submeshes
+    std::vector<std::string> chunks;
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        chunks.push_back(std::string(4, '\0') + meshes[i].Vertices);
+
+        for (size_t k = 0; k < meshes[i].Submeshes.size(); k++)
+            chunks.push_back(std::string(4, '\0') + meshes[i].Submeshes[k]);
+    }
+
+    unsigned int removableBegin = dataBegin + data.size();
+    std::string info, chunkData;
+    unsigned long long chunkOffset = removableBegin + 16 * chunks.size();
+
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        put64(info, chunks[i].size());
+        put64(info, chunkOffset);
+        chunkOffset += chunks[i].size();
+        chunkData += chunks[i];
+    }
+
+    std::string file = "BRES";
+    put16(file, 0xfeff);
+    put16(file, 0);                       // version
+    put32(file, headerSize);
+    put32(file, chunkOffset);             // file size
+    put32(file, 1);                       // offset table entries
+    put32(file, 0);                       // origin
+    put64(file, offsetTable);
+    put64(file, dataBegin);               // (empty String Data section)
+    put64(file, dataBegin);
+    put64(file, dataBegin + relatedFiles);
+    put64(file, removableBegin);
+    put32(file, info.size() + chunkData.size());
+    put32(file, chunks.size());
+    put32(file, 1);                       // separated allocation of the removable chunks
+    put32(file, 0);                       // dynamic chunk
+
+    put64(file, 0); // offset table
+    return file + data + info + chunkData;
+}
+
+static std::string readFile(const std::string &fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    std::ostringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+static int countOf(const std::string &text, const std::string &pattern)
+{
+    int count = 0;
+
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        count++;
+
+    return count;
+}
+
+int main()
+{
+    namespace fs = std::filesystem;
+
+    // 1. Write the models: one with the float variant, one with only the quantized variant, and one whose float variant is damaged.
+    fs::remove_all(TEST_DIRECTORY);
+    fs::create_directories(TEST_DIRECTORY "/model");
+
+    std::vector<TestMesh> meshes;
+    meshes.push_back(makeGrid(12, 0.0f));
+    meshes.push_back(makeGrid(5, 20.0f));
+
+    std::string model = makeModel(meshes);
+
+    bool written = writeZip(TEST_DIRECTORY "/model/float.bdae", "little_endian_not_quantized.bdae", model) &&
+                   writeZip(TEST_DIRECTORY "/model/quantized.bdae", "little_endian_quantized.bdae", std::string(256, 'q')) &&
+                   writeZip(TEST_DIRECTORY "/model/damaged.bdae", "little_endian_not_quantized.bdae", model.substr(0, 100));
+
+    if (!written)
+    {
+        printf("FAILED: can't write the test models\n");
+        return 1;
+    }
+
+    // 2. Export the directory: only the damaged model counts as failed.
+    int failed = ExportDirectoryToGLB(TEST_DIRECTORY "/model", TEST_DIRECTORY "/export", 2);
+    CHECK(failed == 1, "%d models failed instead of 1 (the quantized model must be skipped, not failed)", failed);
+    CHECK(!fs::exists(TEST_DIRECTORY "/export/quantized.glb"), "the quantized model was exported");
+    CHECK(!fs::exists(TEST_DIRECTORY "/export/damaged.glb"), "the damaged model was exported");
+
+    // 3. Check the .glb of the float model: header, one primitive per submesh, and the vertex chunks stored as they are.
+    std::string glb = readFile(TEST_DIRECTORY "/export/float.glb");
+    CHECK(glb.size() >= 28, "float.glb is missing or truncated");
+
+    if (glb.size() >= 28)
+    {
+        unsigned int header[5];
+        memcpy(header, glb.data(), sizeof(header));
+        CHECK(header[0] == 0x46546C67 && header[1] == 2, "float.glb has no glTF 2.0 header");
+        CHECK(header[2] == glb.size(), "float.glb has length %u instead of %zu", header[2], glb.size());
+        CHECK(header[4] == 0x4E4F534A && 20 + (size_t)header[3] <= glb.size(), "float.glb has no JSON chunk");
+
+        std::string json = glb.substr(20, std::min<size_t>(header[3], glb.size() - 20));
+        std::string binary = glb.substr(std::min<size_t>(20 + header[3] + 8, glb.size()));
+
+        CHECK(countOf(json, "\"primitives\"") == 2, "float.glb has %d meshes instead of 2", countOf(json, "\"primitives\""));
+        CHECK(countOf(json, "\"indices\"") == 4, "float.glb has %d primitives instead of 4", countOf(json, "\"indices\""));
+        CHECK(json.find("\"byteStride\":48") != std::string::npos, "the vertex chunks of float.glb are not stored with their stride");
+
+        for (size_t i = 0; i < meshes.size(); i++)
+            CHECK(binary.find(meshes[i].Vertices) != std::string::npos, "the vertex chunk of mesh %zu is not stored as it is", i + 1);
+    }
+
+    fs::remove_all(TEST_DIRECTORY);
+
+    printf(failures ? "%d FAILURES\n" : "all passed\n", failures);
+    return failures ? 1 : 0;
+}
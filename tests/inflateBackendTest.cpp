@@ -0,0 +1,200 @@
+/*
+    Round trip test of the inflate backends: streams made by zlib's deflate (stored, fixed and dynamic blocks) must be decoded by inflateBufferFast() exactly as by zlib, and corrupt streams must be rejected by both or decoded identically.
+    Also prints the speed of both decoders on a large stream.
+    ____________________________________________________________________________________________________________________________________________________
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <zlib.h>
+#include "../libs/io/InflateBackend.h"
+
+static int failures = 0;
+
+#define CHECK(condition, ...)                \
+    do                                       \
+    {                                        \
+        if (!(condition))                    \
+        {                                    \
+            printf("FAILED: " __VA_ARGS__);  \
+            printf("\n");                    \
+            failures++;                      \
+        }                                    \
+    } while (0)
+
+// compresses data into a raw deflate stream (no zlib header, as in the archives)
+static std::vector<unsigned char> deflateRaw(const std::vector<unsigned char> &data, int level, int strategy)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, strategy);
+
+    std::vector<unsigned char> out(deflateBound(&stream, data.size()) + 16);
+    stream.next_in = (Bytef *)(data.empty() ? NULL : &data[0]);
+    stream.avail_in = data.size();
+    stream.next_out = &out[0];
+    stream.avail_out = out.size();
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+// test inputs: random bytes, text-like data, runs, and a mix of them
+static std::vector<unsigned char> makeData(int kind, size_t size, std::mt19937 &random)
+{
+    static const char *const words[] = {"vertex", "index", "texture", "mesh", "submesh", "bone", "material", " ", "\n", "_01", ".tga"};
+    std::vector<unsigned char> data(size);
+
+    for (size_t i = 0; i < size;)
+    {
+        int k = (kind == 3 ? random() % 3 : kind);
+
+        if (k == 0)
+            data[i++] = (unsigned char)random();
+        else if (k == 1)
+        {
+            const char *word = words[random() % (sizeof(words) / sizeof(words[0]))];
+
+            for (size_t j = 0; word[j] && i < size; j++)
+                data[i++] = word[j];
+        }
+        else
+        {
+            unsigned char value = (unsigned char)random();
+
+            for (size_t run = 1 + random() % 300; run && i < size; run--)
+                data[i++] = value;
+        }
+    }
+
+    return data;
+}
+
+// type of the first block of a stream (0 stored, 1 fixed, 2 dynamic)
+static int firstBlockType(const std::vector<unsigned char> &stream)
+{
+    return stream.empty() ? -1 : (stream[0] >> 1) & 3;
+}
+
+// decodes with both backends and compares them: a stream zlib accepts must be decoded identically, a stream zlib rejects must be rejected
+static bool compareDecoders(const std::vector<unsigned char> &stream, size_t outSize)
+{
+    std::vector<unsigned char> expected(outSize + 1), decoded(outSize + 1);
+    const void *in = (stream.empty() ? NULL : &stream[0]);
+
+    bool zlibValid = inflateBufferZlib(&expected[0], outSize, in, stream.size());
+    bool fastValid = inflateBufferFast(&decoded[0], outSize, in, stream.size());
+
+    if (zlibValid != fastValid)
+        return false;
+
+    return !zlibValid || memcmp(&expected[0], &decoded[0], outSize) == 0;
+}
+
+int main()
+{
+    std::mt19937 random(1);
+
+    // 1. Round trip of valid streams: every block type and decoder path (literals, short and long matches, long runs).
+    const size_t sizes[] = {0, 1, 100, 4096, 65536 + 17, 1 << 20};
+    const int levels[] = {0, 1, 6, 9};
+    const int strategies[] = {Z_DEFAULT_STRATEGY, Z_FIXED, Z_HUFFMAN_ONLY, Z_RLE, Z_FILTERED};
+    int blockTypes[3] = {0};
+    int streams = 0;
+
+    for (size_t size : sizes)
+    {
+        for (int kind = 0; kind < 4; kind++)
+        {
+            std::vector<unsigned char> data = makeData(kind, size, random);
+
+            for (int level : levels)
+            {
+                for (int strategy : strategies)
+                {
+                    std::vector<unsigned char> stream = deflateRaw(data, level, strategy);
+                    std::vector<unsigned char> decoded(size + 1);
+
+                    int type = firstBlockType(stream);
+                    if (type >= 0 && type < 3)
+                        blockTypes[type]++;
+
+                    bool valid = inflateBufferFast(&decoded[0], size, stream.empty() ? NULL : &stream[0], stream.size());
+                    CHECK(valid && (size == 0 || memcmp(&decoded[0], &data[0], size) == 0), "round trip of %zu bytes (data %d, level %d, strategy %d)", size, kind, level, strategy);
+
+                    // a wrong output size must be rejected
+                    if (size > 0)
+                        CHECK(!inflateBufferFast(&decoded[0], size - 1, &stream[0], stream.size()), "stream of %zu bytes accepted with a smaller output size", size);
+
+                    streams++;
+                }
+            }
+        }
+    }
+
+    CHECK(blockTypes[0] && blockTypes[1] && blockTypes[2], "not every block type was tested (stored %d, fixed %d, dynamic %d)", blockTypes[0], blockTypes[1], blockTypes[2]);
+    printf("round trip: %d streams (first blocks: %d stored, %d fixed, %d dynamic)\n", streams, blockTypes[0], blockTypes[1], blockTypes[2]);
+
+    // 2. Corrupt streams: flipped bits and truncations of fixed and dynamic streams.
+    int corrupt = 0;
+
+    for (int i = 0; i < 2000; i++)
+    {
+        std::vector<unsigned char> data = makeData(i % 4, 1 + random() % 5000, random);
+        std::vector<unsigned char> stream = deflateRaw(data, 1 + random() % 9, (i & 4) ? Z_FIXED : Z_DEFAULT_STRATEGY);
+
+        if (i % 3 == 0)
+            stream.resize(random() % stream.size());
+        else
+        {
+            for (int flips = 1 + random() % 3; flips; flips--)
+                stream[random() % stream.size()] ^= (unsigned char)(1 << (random() % 8));
+        }
+
+        CHECK(compareDecoders(stream, data.size()), "corrupt stream %d: the decoders disagree", i);
+        corrupt++;
+    }
+
+    // 3. Random byte streams (mostly invalid, some decode as short stored, fixed or dynamic blocks).
+    for (int i = 0; i < 20000; i++)
+    {
+        std::vector<unsigned char> stream(1 + random() % 64);
+
+        for (unsigned char &b : stream)
+            b = (unsigned char)random();
+
+        CHECK(compareDecoders(stream, random() % 200), "random stream %d: the decoders disagree", i);
+        corrupt++;
+    }
+
+    printf("corrupt and random streams: %d\n", corrupt);
+
+    // 4. Speed on a large text-like stream with dynamic blocks.
+    std::vector<unsigned char> data = makeData(3, 16 << 20, random);
+    std::vector<unsigned char> stream = deflateRaw(data, 6, Z_DEFAULT_STRATEGY);
+    std::vector<unsigned char> decoded(data.size());
+    InflateBufferFunc backends[2] = {inflateBufferZlib, inflateBufferFast};
+    const char *names[2] = {"zlib", "fast"};
+
+    for (int b = 0; b < 2; b++)
+    {
+        double best = 1e9;
+
+        for (int run = 0; run < 5; run++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool valid = backends[b](&decoded[0], decoded.size(), &stream[0], stream.size());
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            CHECK(valid && decoded == data, "%s decoder on the large stream", names[b]);
+        }
+
+        printf("%s: %.0f MB/s\n", names[b], data.size() / best / 1e6);
+    }
+
+    printf(failures ? "%d FAILURES\n" : "all passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,281 @@
+/*
+    Test of the lookups of CIndexedPackPatchReader through its hash index: every entry of a pack and of a patch added to it must be found by its name (in any case, with or without a leading "./"), at the same position as the binary search of CPackResReader::findFile(), with the patched entries taking precedence; names that are not in the pack must not be found.
+    Then the pack is opened through an index file (CPackIndexCache): it must be written by the first open and used by the next one, and a pack rewritten with the same size right after must not be read through its stale index.
+    The pack and the patch are zip files written by the test (stored and deflated entries).
+    ____________________________________________________________________________________________________________________________________________________
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "../libs/io/CIndexedPackPatchReader.h"
+
+#define PACK_NAME "packFileIndexTest.zip"
+#define PATCH_NAME "packFileIndexTest_patch.zip"
+#define INDEX_NAME "packFileIndexTest.zip.idx"
+#define MAIN_COUNT 3000
+#define PATCHED_EVERY 20 // every 20th entry of the main pack is replaced by the patch
+#define NEW_COUNT 100    // entries that only the patch has
+
+static int failures = 0;
+
+#define CHECK(condition, ...)                \
+    do                                       \
+    {                                        \
+        if (!(condition))                    \
+        {                                    \
+            printf("FAILED: " __VA_ARGS__);  \
+            printf("\n");                    \
+            failures++;                      \
+        }                                    \
+    } while (0)
+
+struct ZipEntry
+{
+    std::string Name;
+    std::string Data;
+};
+
+static void put16(std::string &out, unsigned int value)
+{
+    out.push_back((char)(value & 0xff));
+    out.push_back((char)(value >> 8 & 0xff));
+}
+
+static void put32(std::string &out, unsigned int value)
+{
+    put16(out, value & 0xffff);
+    put16(out, value >> 16);
+}
+
+// writes a zip file, the entries of odd size deflated (so the size of the zip does not depend on the order of the entries)
+static bool writeZip(const char *fileName, const std::vector<ZipEntry> &entries)
+{
+    std::string zip, directory;
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const ZipEntry &entry = entries[i];
+        unsigned int crc = crc32(0, (const Bytef *)entry.Data.data(), entry.Data.size());
+        unsigned int method = (entry.Data.size() % 2 ? 8 : 0);
+        std::string data = entry.Data;
+
+        if (method == 8)
+        {
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            deflateInit2(&stream, 6, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+            std::vector<char> out(deflateBound(&stream, entry.Data.size()));
+            stream.next_in = (Bytef *)entry.Data.data();
+            stream.avail_in = entry.Data.size();
+            stream.next_out = (Bytef *)&out[0];
+            stream.avail_out = out.size();
+            deflate(&stream, Z_FINISH);
+            data.assign(&out[0], stream.total_out);
+            deflateEnd(&stream);
+        }
+
+        unsigned int offset = zip.size();
+        std::string header;
+        put16(header, 20);                   // version needed
+        put16(header, 0);                    // flags
+        put16(header, method);
+        put32(header, 0);                    // time and date
+        put32(header, crc);
+        put32(header, data.size());
+        put32(header, entry.Data.size());
+        put16(header, entry.Name.size());
+        put16(header, 0);                    // extra field length
+
+        put32(zip, 0x04034b50);
+        zip += header + entry.Name + data;
+
+        put32(directory, 0x02014b50);
+        put16(directory, 20);                // version made by
+        directory += header;
+        put16(directory, 0);                 // comment length
+        put16(directory, 0);                 // disk
+        put16(directory, 0);                 // internal attributes
+        put32(directory, 0);                 // external attributes
+        put32(directory, offset);
+        directory += entry.Name;
+    }
+
+    unsigned int directoryOffset = zip.size();
+    zip += directory;
+    put32(zip, 0x06054b50);
+    put16(zip, 0);
+    put16(zip, 0);
+    put16(zip, entries.size());
+    put16(zip, entries.size());
+    put32(zip, directory.size());
+    put32(zip, directoryOffset);
+    put16(zip, 0);
+
+    FILE *file = fopen(fileName, "wb");
+
+    if (!file)
+        return false;
+
+    bool written = (fwrite(zip.data(), 1, zip.size(), file) == zip.size());
+    return fclose(file) == 0 && written;
+}
+
+static std::string entryName(int i)
+{
+    return (i < MAIN_COUNT ? "dir" + std::to_string(i % 7) + "/file_" + std::to_string(i) + ".bdae" : "new/file_" + std::to_string(i) + ".bdae");
+}
+
+// contents of an entry as the patched pack must return it
+static std::string expectedData(int i)
+{
+    bool patched = (i >= MAIN_COUNT || i % PATCHED_EVERY == 0);
+    return std::string(patched ? "patch " : "main ") + std::to_string(i) + std::string(i % 50, 'x');
+}
+
+static std::string readEntry(IReadResFile *file)
+{
+    std::string data(file->getSize(), 0);
+
+    if (!data.empty() && file->read(&data[0], data.size()) != (S32)data.size())
+        data = "(read error)";
+
+    return data;
+}
+
+int main()
+{
+    // 1. Write the pack and the patch.
+    std::vector<ZipEntry> pack, patch;
+
+    for (int i = 0; i < MAIN_COUNT; i++)
+        pack.push_back(ZipEntry{entryName(i), "main " + std::to_string(i) + std::string(i % 50, 'x')});
+
+    for (int i = 0; i < MAIN_COUNT + NEW_COUNT; i++)
+    {
+        if (i >= MAIN_COUNT || i % PATCHED_EVERY == 0)
+            patch.push_back(ZipEntry{entryName(i), expectedData(i)});
+    }
+
+    if (!writeZip(PACK_NAME, pack) || !writeZip(PATCH_NAME, patch))
+    {
+        printf("FAILED: can't write the test packs\n");
+        return 1;
+    }
+
+    // 2. Look every entry up through the index, before and after the patch is added.
+    CIndexedPackPatchReader *reader = new CIndexedPackPatchReader(PACK_NAME, true, false);
+    CHECK(reader->getFileCount() == MAIN_COUNT, "the pack has %d entries instead of %d", reader->getFileCount(), MAIN_COUNT);
+
+    for (int i = 0; i < MAIN_COUNT; i++)
+        CHECK(reader->findFile(entryName(i).c_str()) == reader->CPackResReader::findFile(entryName(i).c_str()), "%s: the index and the binary search differ before the patch", entryName(i).c_str());
+
+    CHECK(reader->addPackPatchFile(PATCH_NAME), "the patch could not be added");
+
+    int lookups = 0;
+
+    for (int i = 0; i < MAIN_COUNT + NEW_COUNT; i++)
+    {
+        std::string name = entryName(i);
+        std::string upper = name, dotted = "./" + name;
+
+        for (size_t j = 0; j < upper.size(); j++)
+            upper[j] = (char)toupper(upper[j]);
+
+        const char *variants[3] = {name.c_str(), upper.c_str(), dotted.c_str()};
+
+        for (int v = 0; v < 3; v++)
+        {
+            int32 index = reader->findFile(variants[v]);
+            CHECK(index >= 0, "%s was not found", variants[v]);
+
+            // the binary search finds the same entry (merging the patch can append a patched name instead of redirecting its entry, then only the contents must match)
+            if (i < MAIN_COUNT && i % PATCHED_EVERY != 0)
+                CHECK(index == reader->CPackResReader::findFile(variants[v]), "%s: the index and the binary search differ", variants[v]);
+
+            IReadResFile *file = reader->openFileView(variants[v]);
+            CHECK(file && readEntry(file) == expectedData(i), "%s: wrong contents", variants[v]);
+
+            if (file)
+                file->drop();
+
+            lookups++;
+        }
+    }
+
+    const char *missing[] = {"dir0/file_1.bdae", "new/file_0.bdae", "file_0.bdae", "dir0", "", "dir0/file_0.bdae.lod"};
+
+    for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++)
+    {
+        CHECK(reader->findFile(missing[i]) == -1, "%s was found although it is not in the pack", missing[i]);
+        CHECK(reader->openFileView(missing[i]) == 0, "%s was opened although it is not in the pack", missing[i]);
+    }
+
+    printf("lookups through the index: %d\n", lookups);
+    reader->drop();
+
+    // 3. Open the pack through its index file three times: the first open writes it, the second one uses it, the third one follows a rewrite of the pack with the same entries in reverse order (the same size, but other positions).
+    remove(INDEX_NAME);
+
+    struct stat written;
+    memset(&written, 0, sizeof(written));
+
+    for (int open = 0; open < 3; open++)
+    {
+        if (open == 2)
+        {
+            // (past the granularity of the file times of the system)
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            std::vector<ZipEntry> reversed(pack.rbegin(), pack.rend());
+            writeZip(PACK_NAME, reversed);
+        }
+
+        IReadResFile *packFile = createMappedReadFile(PACK_NAME);
+        reader = new CIndexedPackPatchReader(packFile, true, false, INDEX_NAME);
+        packFile->drop();
+
+        int wrong = 0;
+
+        for (int i = 0; i < MAIN_COUNT; i++)
+        {
+            IReadResFile *file = reader->openFileView(entryName(i).c_str());
+
+            if (!file || readEntry(file) != pack[i].Data)
+                wrong++;
+
+            if (file)
+                file->drop();
+        }
+
+        CHECK(reader->getFileCount() == MAIN_COUNT && wrong == 0, "open %d through the index file: %d entries, %d of them wrong", open, reader->getFileCount(), wrong);
+        reader->drop();
+
+        // the index file is replaced (by a rename) only when it is written
+        struct stat status;
+        CHECK(stat(INDEX_NAME, &status) == 0, "open %d: there is no index file", open);
+
+#ifndef _WIN32
+        if (open == 1)
+            CHECK(status.st_ino == written.st_ino, "the index file was written again although the pack did not change");
+        if (open == 2)
+            CHECK(status.st_ino != written.st_ino, "the index file was not written again after the pack changed");
+#endif
+        written = status;
+    }
+
+    printf("opens through the index file: 3\n");
+
+    remove(PACK_NAME);
+    remove(PATCH_NAME);
+    remove(INDEX_NAME);
+
+    printf(failures ? "%d FAILURES\n" : "all passed\n", failures);
+    return failures ? 1 : 0;
+}
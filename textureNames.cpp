@@ -0,0 +1,257 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include "textureNames.h"
+
+//! Finds the texture files of a parsed model.
+// ___________________________________________
+
+int FindTextureNames(const char *fpath, const File &file, int &textureCount, std::vector<std::string> &textureNames)
+{
+    int alternativeTextureCount = 0;
+    textureNames.clear();
+
+    // normalize model path for cross-platform compatibility (Windows uses '\', Linux uses '/')
+    std::string modelPath(fpath);
+    std::replace(modelPath.begin(), modelPath.end(), '\\', '/');
+
+    // retrieve model subpath (empty if the model is not inside a 'model' folder)
+    std::string textureSubpath;
+    const char *subpathStart = std::strstr(modelPath.c_str(), "/model/");
+
+    if (subpathStart)
+    {
+        subpathStart += 7;                                                  // subpath starts after '/model/' (texture and model files have the same subpath, e.g. 'creature/pet/')
+        const char *subpathEnd = std::strrchr(modelPath.c_str(), '/') + 1; // last '/' before the file name
+        textureSubpath.assign(subpathStart, subpathEnd);
+    }
+
+    bool isAlphaRef = false;       // for debugging textures
+    bool isUnsortedFolder = false; // for 'unsorted' folder
+
+    if (textureSubpath.rfind("unsorted/", 0) == 0)
+        isUnsortedFolder = true;
+
+    // [TODO] implement a more robust approach
+    // loop through each retrieved string and find those that are texture names
+    for (int i = 0, n = file.StringStorage.size(); i < n; i++)
+    {
+        std::string s = file.StringStorage[i];
+
+        if (s == "alpharef")
+            isAlphaRef = true;
+
+        // convert to lowercase
+        for (char &c : s)
+            c = std::tolower(c);
+
+        // remove 'avatar/' if it exists
+        int avatarPos = s.find("avatar/");
+        if (avatarPos != std::string::npos && !isUnsortedFolder)
+            s.erase(avatarPos, 7);
+
+        // remove 'texture/' if it exists
+        if (s.rfind("texture/", 0) == 0)
+            s.erase(0, 8);
+
+        // a string is a texture file name if it ends with '.tga' and doesn't start with '_'
+        if (s.length() >= 4 && s.compare(s.length() - 4, 4, ".tga") == 0 && s[0] != '_' && s.substr(0, 3) != "e:/")
+        {
+            // replace the ending with '.png'
+            s.replace(s.length() - 4, 4, ".png");
+
+            // build final path
+            if (!isUnsortedFolder)
+                s = "texture/" + textureSubpath + s;
+            else
+                s = "texture/unsorted/" + s;
+
+            // ensure it is a unique texture name
+            if (std::find(textureNames.begin(), textureNames.end(), s) == textureNames.end())
+                textureNames.push_back(s);
+        }
+    }
+
+    std::string fileName = modelPath.substr(modelPath.find_last_of("/\\") + 1); // file name is after the last path separator in the full path
+
+    // if a texture file matching the model file name exists, override the parsed texture (for single-texture models only)
+    std::string s = "texture/" + textureSubpath + fileName;
+    s.replace(s.length() - 5, 5, ".png");
+
+    if (textureCount == 1 && std::filesystem::exists(s))
+    {
+        textureNames.clear();
+        textureNames.push_back(s);
+    }
+
+    // if a texture name is missing in the .bdae file, use this file's name instead (assuming the texture file was manually found and named)
+    if (textureNames.empty())
+    {
+        textureNames.push_back(s);
+        textureCount++;
+    }
+
+    for (int i = 0; i < textureNames.size(); i++)
+        File::Log() << "[" << i + 1 << "]  " << textureNames[i] << std::endl;
+
+    // search for alternative texture files
+    // [TODO] handle for multi-texture models
+    if (textureNames.size() == 1 && std::filesystem::exists(textureNames[0]) && !isUnsortedFolder)
+    {
+        std::filesystem::path texturePath("texture/" + textureSubpath);
+        std::string baseTextureName = std::filesystem::path(textureNames[0]).stem().string(); // texture file name without extension or folder (e.g. 'boar_01' or 'puppy_bear_black')
+
+        std::string groupName; // name shared by a group of related textures
+
+        // naming rule #1
+        if (baseTextureName.find("lvl") != std::string::npos && baseTextureName.find("world") != std::string::npos)
+            groupName = baseTextureName;
+
+        // naming rule #2
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(texturePath))
+        {
+            if (!entry.is_regular_file())
+                continue;
+
+            std::filesystem::path entryPath = entry.path();
+
+            if (entryPath.extension() != ".png")
+                continue;
+
+            std::string baseEntryName = entryPath.stem().string();
+
+            if (baseEntryName.rfind(baseTextureName + '_', 0) == 0 &&                                  // starts with '<baseTextureName>_'
+                baseEntryName.size() > baseTextureName.size() + 1 &&                                   // has at least one character after the underscore
+                std::isdigit(static_cast<unsigned char>(baseEntryName[baseTextureName.size() + 1])) && // first character after '_' is a digit
+                entryPath.string() != textureNames[0])                                                 // not the original base texture itself
+            {
+                groupName = baseTextureName;
+                break;
+            }
+        }
+
+        // for a numeric suffix (e.g. '_01', '_2'), remove it if exists (to derive a group name for searching potential alternative textures, e.g 'boar')
+        if (groupName.empty())
+        {
+            auto lastUnderscore = baseTextureName.rfind('_');
+
+            if (lastUnderscore != std::string::npos)
+            {
+                std::string afterLastUnderscore = baseTextureName.substr(lastUnderscore + 1);
+
+                if (!afterLastUnderscore.empty() && std::all_of(afterLastUnderscore.begin(), afterLastUnderscore.end(), ::isdigit))
+                    groupName = baseTextureName.substr(0, lastUnderscore);
+            }
+        }
+
+        // for a non numeric‑suffix (e.g. '_black'), use the “max‑match” approach to find the best group name
+        if (groupName.empty())
+        {
+            // build a list of all possible prefixes (e.g. 'puppy_black_bear', 'puppy_black', 'puppy')
+            std::vector<std::string> prefixes;
+            std::string s = baseTextureName;
+
+            while (true)
+            {
+                prefixes.push_back(s);
+                auto pos = s.rfind('_');
+
+                if (pos == std::string::npos)
+                    break;
+
+                s.resize(pos); // remove the last '_suffix'
+            }
+
+            // try each prefix and find the one that gives the highest number of matching texture files
+            int bestCount = 0;
+
+            for (int i = 0, n = prefixes.size(); i < n; i++)
+            {
+                int count = 0;
+                std::string pref = prefixes[i];
+
+                // skip single-word prefixes ('puppy' cannot be a group name, otherwise puppy_wolf.png could be an alternative)
+                if (pref.find('_') == std::string::npos)
+                    continue;
+
+                // loop through each file in the texture directory and count how many .png files start with '<pref>_'
+                for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(texturePath))
+                {
+                    if (!entry.is_regular_file())
+                        continue;
+
+                    std::filesystem::path entryPath = entry.path();
+
+                    if (entryPath.extension() != ".png")
+                        continue;
+
+                    if (entryPath.stem().string().rfind(pref + '_', 0) == 0)
+                        count++;
+                }
+
+                // compare and update the best count; if two prefixes match the same number of textures, prefer the longer one
+                if (count > bestCount || (count == bestCount && pref.length() > groupName.length()))
+                {
+                    bestCount = count;
+                    groupName = pref;
+                }
+            }
+        }
+
+        // finally, collect textures based on the best group name
+        if (!groupName.empty())
+        {
+            std::vector<std::string> found;
+
+            for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(texturePath))
+            {
+                if (!entry.is_regular_file())
+                    continue;
+
+                std::filesystem::path entryPath = entry.path();
+
+                if (entryPath.extension() != ".png")
+                    continue;
+
+                // skip the file if its name doesn't exactly match the group name, and doesn’t start with the group name followed by an underscore.
+                if (!(entryPath.stem().string() == groupName || entryPath.stem().string().rfind(groupName + '_', 0) == 0))
+                    continue;
+
+                std::string alternativeTextureName = "texture/" + textureSubpath + entryPath.filename().string();
+
+                // skip the original base texture (already in textureNames[0])
+                if (alternativeTextureName == textureNames[0])
+                    continue;
+
+                // ensure it is a unique texture name
+                if (std::find(textureNames.begin(), textureNames.end(), alternativeTextureName) == textureNames.end())
+                {
+                    found.push_back(alternativeTextureName);
+                    alternativeTextureCount++;
+                }
+            }
+
+            if (!found.empty())
+            {
+                // append and report
+                textureNames.insert(textureNames.end(), found.begin(), found.end());
+
+                File::Log() << "Found " << found.size() << " alternative(s) for '" << groupName << "':\n";
+
+                for (int i = 0; i < found.size(); i++)
+                    File::Log() << "  " << found[i] << "\n";
+            }
+            else
+                File::Log() << "No alternatives found for group '" << groupName << "'\n";
+        }
+        else
+            File::Log() << "No valid grouping name for '" << baseTextureName << "'\n";
+    }
+
+
+    // if (isAlphaRef)
+    //     File::Log() << "\nALPHAREF" << std::endl;
+
+    return alternativeTextureCount;
+}
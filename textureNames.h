@@ -0,0 +1,16 @@
+#ifndef __TEXTURENAMES_H_INCLUDED__
+#define __TEXTURENAMES_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include "resFile.h"
+
+/*
+    Texture files of a parsed model, found from the texture names among its strings.
+    The models are expected in a 'model' folder and their textures (converted to .png) in a 'texture' folder with the same subpath, e.g. 'model/creature/pet/boar.bdae' uses 'texture/creature/pet/boar_01.png'; the returned paths are relative to the working directory.
+*/
+
+// fills textureNames with the textures of the model followed by its alternative textures (other colors found next to them), and returns the number of alternative textures; textureCount is the texture count of the model, increased if the model file name has to be used as its texture name
+int FindTextureNames(const char *modelPath, const File &file, int &textureCount, std::vector<std::string> &textureNames);
+
+#endif
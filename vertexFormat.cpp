@@ -0,0 +1,42 @@
+#include <cstring>
+#include <algorithm>
+#include "vertexFormat.h"
+
+VertexFormat GetFloatVertexFormat(int stride)
+{
+    VertexFormat format;
+
+    format.Stride = stride;
+    format.Position.Offset = 0;
+    format.Normal.Offset = 12;
+    format.TexCoord.Offset = 24;
+
+    return format;
+}
+
+int GetVertexFormatSize(const VertexFormat &format)
+{
+    int size = format.Position.Offset + 3 * sizeof(float);
+    size = std::max<int>(size, format.Normal.Offset + 3 * sizeof(float));
+    size = std::max<int>(size, format.TexCoord.Offset + 2 * sizeof(float));
+    return size;
+}
+
+void DecodeVertices(const VertexFormat &format, const unsigned char *data, int vertexCount, float *out)
+{
+    // the attributes of the not quantized format lie one after another, so each vertex is copied at once
+    if (format.Position.Offset == 0 && format.Normal.Offset == 12 && format.TexCoord.Offset == 24)
+    {
+        for (int i = 0; i < vertexCount; i++)
+            memcpy(out + i * DECODED_VERTEX_SIZE, data + i * format.Stride, DECODED_VERTEX_SIZE * sizeof(float));
+
+        return;
+    }
+
+    for (int i = 0; i < vertexCount; i++, data += format.Stride, out += DECODED_VERTEX_SIZE)
+    {
+        memcpy(out, data + format.Position.Offset, 3 * sizeof(float));
+        memcpy(out + 3, data + format.Normal.Offset, 3 * sizeof(float));
+        memcpy(out + 6, data + format.TexCoord.Offset, 2 * sizeof(float));
+    }
+}
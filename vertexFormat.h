@@ -0,0 +1,38 @@
+#ifndef __VERTEXFORMAT_H_INCLUDED__
+#define __VERTEXFORMAT_H_INCLUDED__
+
+/*
+    Description and decoding of the vertex streams of .bdae meshes.
+    The not quantized variant ('little_endian_not_quantized.bdae') stores 32-bit floats: position, normal and texture coordinates at the beginning of each vertex, followed by further attributes up to the stride of the mesh.
+    The viewer works with 8 floats per vertex (position, normal, texture coordinates), so the decoder copies these attributes out of the stride of the mesh.
+    The quantized variant ('little_endian_quantized.bdae') is not supported: where it keeps its stride, attribute types and offsets and its per-mesh position scale / bias is not known, so the viewer and the exporter load the float variant only.
+    ________________________________________________________________________________________________________________________________________________________________________
+*/
+
+struct VertexAttribute
+{
+    int Offset; // offset from the beginning of the vertex in bytes (the components are 32-bit floats)
+};
+
+struct VertexFormat
+{
+    int Stride; // size of one vertex in bytes
+
+    VertexAttribute Position; // 3 components
+    VertexAttribute Normal;   // 3 components
+    VertexAttribute TexCoord; // 2 components
+};
+
+// number of floats per decoded vertex: X, Y, Z, Nx, Ny, Nz, S, T
+#define DECODED_VERTEX_SIZE 8
+
+// format of the not quantized variant: 3 positions, 3 normals, 2 texture coordinates at the beginning of each vertex
+VertexFormat GetFloatVertexFormat(int stride);
+
+// returns the number of bytes a vertex of the format needs (the stride must be at least that)
+int GetVertexFormatSize(const VertexFormat &format);
+
+// decodes vertexCount vertices into DECODED_VERTEX_SIZE floats each
+void DecodeVertices(const VertexFormat &format, const unsigned char *data, int vertexCount, float *out);
+
+#endif